@@ -1,6 +1,6 @@
 #include "areaframe.h"
 
-AreaFrame::AreaFrame(const QColor& color, const QString& name, QJsonObject* configJson, QWidget* parent)
+AreaFrame::AreaFrame(const QColor& color, const QString& name, GoalModel* goals, ConfigStorage* storage, QWidget* parent)
     : QFrame{parent}, webEngine{this}, layout{this}
 {
 
@@ -11,7 +11,8 @@ AreaFrame::AreaFrame(const QColor& color, const QString& name, QJsonObject* conf
     webEngine.page()->setWebChannel(channel);
 
 
-    this->configJson = configJson;
+    this->goals = goals;
+    this->storage = storage;
 
     layout.addWidget(&webEngine);
     layout.setContentsMargins(0,0,0,0); // This removes the margin between the edge of the frame and the html content
@@ -83,32 +84,14 @@ void AreaFrame::repopulate() {
  ********************************************************************************************************/
 
 void AreaFrame::inputSubmitted(const QString &input, const QString goalNumber) {
-    // Get this area's goals
-    QJsonArray goalsArray = (*configJson)[this->name].toArray();
-    QString targetValue;
-
-    int i = 0;
-    for (auto&& goal : goalsArray){ // Iterate over the goals
-
-        // If i is equal to the goalNumber as an int
-        if (i == goalNumber.toInt()) {
-            // Convert that copy of the goal to be an object
-            QJsonObject goalObj = goal.toObject();
-            // Set the current value of the goal to be the submitted value
-            goalObj["current_value"] = input;
-
-            // Save the target value (this is only used for the funny box)
-            targetValue = goalObj["target_value"].toString();
-
-            // Set the goal to be the copy with changed current value
-            goal = goalObj;
-            break;
-        }
-        // Increase i
-        i++;
+    // Find which goal the page means and set its current value to be the submitted value
+    int position = goalNumber.toInt();
+    if (position < 0 || position >= renderedIds.size() || !goals->setCurrentValue(renderedIds[position], input)) {
+        return;
     }
-    // Set the this area's goals to be the edited array
-    (*configJson)[this->name] = goalsArray;
+
+    // Save the target value (this is only used for the funny box)
+    QString targetValue = goals->find(renderedIds[position])->targetValue;
 
 
     // Create a message box saying that the information was submitted that closes automatically in 1 second
@@ -149,31 +132,8 @@ void AreaFrame::inputSubmitted(const QString &input, const QString goalNumber) {
  ********************************************************************************************************/
 
 void AreaFrame::rewriteJson(){
-    // Create a lockfile
-    QLockFile lockFile("config.json.lock");
-
-    // Try to lock said lockfile for 1000 milliseconds .1 second
-    if (!lockFile.tryLock(1000)) {
-
-        // If it can't access said lock file (somthing else has it locked already try again in 5000 milliseconds
-        QTimer::singleShot(5000, this, [=](){
-            this->rewriteJson();
-        });
-        return;
-    }
-
-    // Lock was sucssessfull so open the config.json file and rewrite it
-    QFile file("config.json");
-    if (file.open(QIODevice::WriteOnly)) {
-        QJsonDocument jsonDocument(*configJson);
-        file.write(jsonDocument.toJson());
-        file.close();
-    } else { // If unable to open the file for writing show a messagebox with that information
-        QMessageBox::critical(nullptr, "Error", "Failed to open file for writing:\n" + file.errorString());
-    }
-
-    // Unlock the lockfile so something else can access the file at a later point
-    lockFile.unlock();
+    // Only this area is written (with config.d/ that is only this area's file)
+    storage->writeArea(name);
 }
 
 QString AreaFrame::getCSS() {
@@ -240,29 +200,28 @@ QString AreaFrame::getBody() {
     // Add the area name as the title as well as a line underneath the title
     html += "<body><h1>" + name + "</h1>" + "<hr>";
 
-    // Add each goal
-    int i = 0;
-    QJsonArray areaArray = configJson->value(name).toArray();
-    foreach (const QJsonValue &value, areaArray) {
-        if (value.isObject()) {
-            QJsonObject goal = value.toObject();
-
-            QString goalName = goal.value("name").toString();
-            QString targetValue = goal.value("target_value").toString();
-            QString currentValue = goal.value("current_value").toString();
-            QString endDate = goal.value("end_date").toString();
-            QString goalNum = QString::number(i);
-
-            html += "<h3 id='title_" + goalNum + "'>" + goalName + "</h3>"
-                    "<div>"
-                        "Target: <span id='targetValue_" + goalNum +"'>" + targetValue + "</span> <br>"
-                        "<span id='progressLabel_" + goalNum + "'> Current Progress: " + "<input type='text'  value='" + currentValue + "' id='" + goalNum + "'>"
-                            "<button type='button' class='button_" + goalNum +"' onclick='handleButton(" + goalNum + ", 1)'>+</button>"
-                            "<button type='button' class='button_" + goalNum +"' onclick='handleButton(" + goalNum + ", -1)'>–</button> </span><br>"
-                        "<span id='finishLabel_" + goalNum + "'> Finish By: <span id='endDate_" + goalNum +"'>" + endDate + "</span> </span> <br>"
-                    "</div>";
-            i++;
-        }
+    // Add each goal, soonest end date first. The page numbers them in that order and renderedIds maps the numbers back
+    // The snapshot is held for the whole render, the goals can't change halfway through
+    ConfigSnapshotPtr snapshot = goals->snapshot();
+    renderedIds.clear();
+    for (const Goal *goal : snapshot->ordered(name)) {
+        QString goalName = goal->name;
+        QString targetValue = goal->targetValue;
+        QString currentValue = goal->currentValue;
+        // The page gets the date formatted along with whether it is due so it never parses dates itself
+        QDate end = goal->endDate;
+        QString endDate = end.isValid() ? end.toString() : goal->extra.value("end_date").toString();
+        QString goalNum = QString::number(renderedIds.size());
+        renderedIds.append(goal->id);
+
+        html += "<h3 id='title_" + goalNum + "'>" + goalName + "</h3>"
+                "<div>"
+                    "Target: <span id='targetValue_" + goalNum +"'>" + targetValue + "</span> <br>"
+                    "<span id='progressLabel_" + goalNum + "'> Current Progress: " + "<input type='text'  value='" + currentValue + "' id='" + goalNum + "'>"
+                        "<button type='button' class='button_" + goalNum +"' onclick='handleButton(" + goalNum + ", 1)'>+</button>"
+                        "<button type='button' class='button_" + goalNum +"' onclick='handleButton(" + goalNum + ", -1)'>–</button> </span><br>"
+                    "<span id='finishLabel_" + goalNum + "' data-due='" + ConfigSchema::dueClass(end) + "'> Finish By: <span id='endDate_" + goalNum +"'>" + endDate + "</span> </span> <br>"
+                "</div>";
     }
 
     return html;
@@ -272,9 +231,7 @@ QString AreaFrame::getGoalsScript() {
 
     QString html = "";
 
-    QJsonArray areaArray = configJson->value(name).toArray();
-
-    for (int j=0; j<areaArray.size(); j++) {
+    for (int j=0; j<renderedIds.size(); j++) {
         QString goalNum = QString::number(j);
         QString name = "inputField" + goalNum;
         html += "var " + name + " = document.getElementById('" + goalNum + "');"
@@ -289,14 +246,11 @@ QString AreaFrame::getGoalsScript() {
                 "var finishLabel = document.getElementById('finishLabel_" + goalNum + "');"
                 "var inputValue = document.getElementById('" + goalNum + "').value;"
                 "var targetValue = parseFloat(document.getElementById('targetValue_" + goalNum + "').innerText);"
-                "var endDateString = document.getElementById('endDate_" + goalNum + "').innerText;"
-                "var endDate = new Date(endDateString);"
                 ""
                 "var currentValue = parseFloat(inputValue);"
                 ""
                 "var today = new Date();"
                 "today.setHours(0, 0, 0, 0);"
-                "endDate.setHours(0, 0, 0, 0);"
                 ""
                 "if (currentValue >= targetValue) {"
                     "progressLabel.style.color = 'green';"
@@ -311,9 +265,9 @@ QString AreaFrame::getGoalsScript() {
                         "}"
                     "}"
                 "}"
-                "if (endDate < today) {"
+                "if (finishLabel.dataset.due === 'overdue') {"
                     "finishLabel.style.color = 'red';"
-                "} else if (endDate.getTime() === today.getTime()) {"
+                "} else if (finishLabel.dataset.due === 'today') {"
                     "finishLabel.style.color = '#8B4000';"
                 "} else {"
                     "if (today.getMonth() === 3 && today.getDate() === 1) {"
@@ -28,6 +28,11 @@
 
 #include <QDebug>
 
+#include "retrypolicy.h"
+#include "configschema.h"
+#include "goalmodel.h"
+#include "configstorage.h"
+
 
 class AreaFrame : public QFrame
 {
@@ -39,11 +44,14 @@ private:
     QWebEngineView webEngine;
     QVBoxLayout layout;
     QWebChannel *channel;
-    QJsonObject* configJson;
+    GoalModel* goals;
+    ConfigStorage* storage;
+    // The id of each goal on the page, the page numbers its goals 0, 1, 2... in the order they are shown
+    QVector<QString> renderedIds;
     bool isDarkMode = false;
 
 public:
-    explicit AreaFrame(const QColor& color, const QString& name, QJsonObject* configJson, QWidget* parent = nullptr);
+    explicit AreaFrame(const QColor& color, const QString& name, GoalModel* goals, ConfigStorage* storage, QWidget* parent = nullptr);
 
     ~AreaFrame(){
         emit aboutToClose();
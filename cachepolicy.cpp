@@ -0,0 +1,48 @@
+#include "cachepolicy.h"
+
+CachePolicies::CachePolicies()
+{
+    CachePolicy orders;
+    policies.insert("orders", orders);
+
+    // Message snapshots are smaller than a month of orders
+    CachePolicy messages;
+    messages.maxEntryBytes = 4 * 1024 * 1024;
+    messages.budgetBytes = 8 * 1024 * 1024;
+    policies.insert("messages", messages);
+
+    CachePolicy token;
+    token.freshSecs = 0;
+    token.staleSecs = 0;
+    token.maxEntryBytes = 0;
+    token.budgetBytes = 0;
+    token.negativeSecs = 30;
+    policies.insert("token", token);
+}
+
+CachePolicies CachePolicies::fromConfig(const QJsonObject &ebayConfigJson) {
+    CachePolicies result;
+
+    QJsonObject overrides = ebayConfigJson.value("eBay").toObject().value("cache_policies").toObject();
+    for (auto it = overrides.constBegin(); it != overrides.constEnd(); it++) {
+        QJsonObject json = it.value().toObject();
+        CachePolicy policy = result.policyFor(it.key());
+
+        policy.freshSecs = json.value("fresh_secs").toInt(policy.freshSecs);
+        policy.staleSecs = json.value("stale_secs").toInt(policy.staleSecs);
+        policy.maxEntryBytes = json.value("max_entry_bytes").toInteger(policy.maxEntryBytes);
+        policy.budgetBytes = json.value("budget_bytes").toInteger(policy.budgetBytes);
+        policy.negativeSecs = json.value("negative_secs").toInt(policy.negativeSecs);
+
+        // A stale limit shorter than the freshness TTL makes no sense, treat it as no stale period
+        if (policy.staleSecs < policy.freshSecs) {
+            policy.staleSecs = policy.freshSecs;
+        }
+        result.policies.insert(it.key(), policy);
+    }
+    return result;
+}
+
+CachePolicy CachePolicies::policyFor(const QString &endpointClass) const {
+    return policies.value(endpointClass, CachePolicy());
+}
@@ -0,0 +1,42 @@
+#ifndef CACHEPOLICY_H
+#define CACHEPOLICY_H
+
+#include <QJsonObject>
+#include <QHash>
+#include <QString>
+
+// How long one class of eBay results (orders, messages, token) is kept, how big it may get and how long an error is remembered
+struct CachePolicy
+{
+    // Fresh entries are used as is, stale ones are shown while a new copy is fetched, after staleSecs they are dropped
+    int freshSecs = 30;
+    int staleSecs = 24 * 60 * 60;
+    // Anything bigger than this isn't cached at all
+    qint64 maxEntryBytes = 8 * 1024 * 1024;
+    // All entries of the class together, the least recently used ones go first once it is over
+    qint64 budgetBytes = 16 * 1024 * 1024;
+    // After a failed call the endpoint is left alone for this long (negative caching)
+    int negativeSecs = 60;
+};
+
+/*
+ * The cache policy table. The defaults can be overridden per class in the eBay section of ebay.config.json, for example
+ *   "cache_policies": { "orders": { "fresh_secs": 60, "budget_bytes": 4000000 }, "token": { "negative_secs": 120 } }
+ * Any field that is left out keeps its default. For the token only negative_secs means anything, the token itself is
+ * kept by the token manager.
+ */
+class CachePolicies
+{
+public:
+    CachePolicies();
+
+    static CachePolicies fromConfig(const QJsonObject &ebayConfigJson);
+
+    // Unknown classes get the default policy
+    CachePolicy policyFor(const QString &endpointClass) const;
+
+private:
+    QHash<QString, CachePolicy> policies;
+};
+
+#endif // CACHEPOLICY_H
@@ -0,0 +1,86 @@
+#include "configschema.h"
+
+const QString ConfigSchema::versionKey = "_schema_version";
+
+QStringList ConfigSchema::areaNames(const QJsonObject &config) {
+    QStringList names;
+    for (const QString &key : config.keys()) {
+        if (isAreaKey(key)) {
+            names.append(key);
+        }
+    }
+    return names;
+}
+
+bool ConfigSchema::isAreaKey(const QString &key) {
+    return !key.startsWith('_');
+}
+
+bool ConfigSchema::migrate(QJsonObject &config) {
+    if (config.value(versionKey).toInt(1) >= currentVersion) {
+        return false;
+    }
+
+    // Version 1 -> 2, every date becomes an ISO date. Anything that isn't an array of goals (like last_changed in
+    // history.json) is left alone
+    for (const QString &area : areaNames(config)) {
+        if (!config.value(area).isArray()) {
+            continue;
+        }
+
+        QJsonArray goals = config.value(area).toArray();
+        for (auto&& goal : goals) {
+            QJsonObject goalObj = goal.toObject();
+            for (const char *field : {"start_date", "end_date"}) {
+                QDate date = parseDate(goalObj.value(field).toString());
+                if (date.isValid()) {
+                    goalObj[field] = formatDate(date);
+                }
+            }
+            goal = goalObj;
+        }
+        config[area] = goals;
+    }
+
+    config[versionKey] = currentVersion;
+    return true;
+}
+
+QDate ConfigSchema::parseDate(const QString &date) {
+    // The current format first, it's what almost everything is
+    QDate parsed = QDate::fromString(date, Qt::ISODate);
+    if (parsed.isValid()) {
+        return parsed;
+    }
+
+    // What QDate::toString() wrote (always English in Qt 6, so this doesn't depend on the locale)
+    parsed = QDate::fromString(date, "ddd MMM d yyyy");
+    if (parsed.isValid()) {
+        return parsed;
+    }
+
+    // The example config
+    return QDate::fromString(date, "MM/dd/yyyy");
+}
+
+QString ConfigSchema::formatDate(const QDate &date) {
+    return date.toString(Qt::ISODate);
+}
+
+ConfigSchema::Due ConfigSchema::dueStatus(const QDate &endDate, const QDate &today) {
+    if (!endDate.isValid() || endDate > today) {
+        return Due::Upcoming;
+    }
+    return endDate == today ? Due::Today : Due::Overdue;
+}
+
+QString ConfigSchema::dueClass(const QDate &endDate) {
+    switch (dueStatus(endDate)) {
+    case Due::Overdue:
+        return "overdue";
+    case Due::Today:
+        return "today";
+    default:
+        return "";
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef CONFIGSCHEMA_H
+#define CONFIGSCHEMA_H
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QStringList>
+#include <QString>
+#include <QDate>
+
+/*
+ * The layout of config.json (and of the goals in history.json).
+ *
+ * Version 1 had no version number and stored dates however they were written: QDate::toString() ("Fri Apr 5 2024") from
+ * the dashboard, "MM/dd/yyyy" in the example config. Version 2 stores every start_date/end_date as an ISO date
+ * ("2024-04-05"), which parses the same everywhere and sorts as plain text. The version lives in "_schema_version" at the
+ * top level, keys starting with an underscore are never areas.
+ *
+ * Old files are migrated when they are loaded, parseDate() still understands every old format so nothing is lost.
+ */
+class ConfigSchema
+{
+public:
+    static const int currentVersion = 2;
+    static const QString versionKey;
+
+    enum class Due
+    {
+        Upcoming,
+        Today,
+        Overdue
+    };
+
+    // The area names in a config (or history) object, leaving out the metadata keys
+    static QStringList areaNames(const QJsonObject &config);
+
+    static bool isAreaKey(const QString &key);
+
+    // Brings config up to the current version, returns true if anything changed (so it should be written back)
+    static bool migrate(QJsonObject &config);
+
+    // Any date format the config has ever had, an invalid QDate if it isn't one of them
+    static QDate parseDate(const QString &date);
+
+    static QString formatDate(const QDate &date);
+
+    static Due dueStatus(const QDate &endDate, const QDate &today = QDate::currentDate());
+
+    // For the goal pages, "overdue", "today" or "" so the page can color the date without parsing it
+    static QString dueClass(const QDate &endDate);
+};
+
+#endif // CONFIGSCHEMA_H
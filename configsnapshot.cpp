@@ -0,0 +1,68 @@
+#include "configsnapshot.h"
+
+quint64 ConfigSnapshot::version() const {
+    return versionNumber;
+}
+
+QStringList ConfigSnapshot::areaNames() const {
+    return areas.keys();
+}
+
+int ConfigSnapshot::goalCount(const QString &area) const {
+    auto it = areas.constFind(area);
+    return it == areas.constEnd() ? 0 : int((*it)->goals.size());
+}
+
+std::shared_ptr<const ConfigSnapshot::Area> ConfigSnapshot::area(const QString &name) const {
+    return areas.value(name);
+}
+
+QVector<const Goal*> ConfigSnapshot::ordered(const QString &area) const {
+    QVector<const Goal*> goals;
+    auto it = areas.constFind(area);
+    if (it == areas.constEnd()) {
+        return goals;
+    }
+
+    goals.reserve((*it)->order.size());
+    for (int position : (*it)->order) {
+        goals.append(&(*it)->goals[position]);
+    }
+    return goals;
+}
+
+const Goal *ConfigSnapshot::find(const QString &id) const {
+    // There are only ever a handful of areas
+    for (const std::shared_ptr<const Area> &area : areas) {
+        auto it = area->byId.constFind(id);
+        if (it != area->byId.constEnd()) {
+            return &area->goals[*it];
+        }
+    }
+    return nullptr;
+}
+
+QJsonObject ConfigSnapshot::toJson() const {
+    QJsonObject config = metadata;
+    for (auto it = areas.constBegin(); it != areas.constEnd(); it++) {
+        config.insert(it.key(), areaToJson(it.key()));
+    }
+    return config;
+}
+
+QJsonArray ConfigSnapshot::areaToJson(const QString &area) const {
+    QJsonArray goals;
+    auto it = areas.constFind(area);
+    if (it == areas.constEnd()) {
+        return goals;
+    }
+
+    for (const Goal &goal : (*it)->goals) {
+        goals.append(goal.toJson());
+    }
+    return goals;
+}
+
+QJsonObject ConfigSnapshot::metadataJson() const {
+    return metadata;
+}
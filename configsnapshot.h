@@ -0,0 +1,71 @@
+#ifndef CONFIGSNAPSHOT_H
+#define CONFIGSNAPSHOT_H
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include <QStringList>
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+#include "goal.h"
+
+/*
+ * One version of config.json that never changes once it is published. GoalModel publishes a new one after every change and
+ * anything that only reads the goals (the pages, the menus, the daily history, anything on another thread) takes the
+ * current one and keeps it for as long as it needs, no lock needed and nothing can change under it.
+ *
+ * Every area is its own shared piece, a new version only has new copies of the areas that changed and shares the rest with
+ * the version before it.
+ */
+class ConfigSnapshot
+{
+public:
+    struct Area
+    {
+        std::vector<Goal> goals;
+        // Positions in goals, soonest end date first
+        QVector<int> order;
+        QHash<QString, int> byId;
+    };
+
+    // Counts up with every published version
+    quint64 version() const;
+
+    QStringList areaNames() const;
+
+    int goalCount(const QString &area) const;
+
+    // Null if there is no such area. An area that didn't change between two snapshots is the same pointer in both
+    std::shared_ptr<const Area> area(const QString &name) const;
+
+    // The area's goals, soonest end date first. The pointers are good for as long as the snapshot is
+    QVector<const Goal*> ordered(const QString &area) const;
+
+    const Goal *find(const QString &id) const;
+
+    // The whole config the way it is stored in config.json
+    QJsonObject toJson() const;
+
+    // One area's goals array
+    QJsonArray areaToJson(const QString &area) const;
+
+    // Everything at the top level that isn't an area
+    QJsonObject metadataJson() const;
+
+private:
+    friend class GoalModel;
+
+    quint64 versionNumber = 0;
+    QMap<QString, std::shared_ptr<const Area>> areas;
+    // Everything at the top level that isn't an area (like the schema version)
+    QJsonObject metadata;
+};
+
+using ConfigSnapshotPtr = std::shared_ptr<const ConfigSnapshot>;
+
+#endif // CONFIGSNAPSHOT_H
@@ -0,0 +1,362 @@
+#include "configstorage.h"
+
+const QString ConfigStorage::singleFile = "config.json";
+const QString ConfigStorage::shardDirectory = "config.d";
+const QString ConfigStorage::metadataFile = "_meta.json";
+
+ConfigStorage::ConfigStorage(GoalModel *goals, IoQueue *io, QObject *parent)
+    : QObject{parent}
+{
+    this->goals = goals;
+    this->io = io;
+    sharded = QDir(shardDirectory).exists();
+    watch();
+
+    QObject::connect(&watcher, &QFileSystemWatcher::fileChanged, this, &ConfigStorage::fileChanged);
+    QObject::connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &ConfigStorage::directoryChanged);
+}
+
+bool ConfigStorage::isSharded() const {
+    return sharded;
+}
+
+void ConfigStorage::read(const QString &area, std::function<void(const QJsonObject &, const QString &)> done) {
+    // Another instance may have split or combined the files since the last read
+    bool nowSharded = QDir(shardDirectory).exists();
+    if (nowSharded != sharded) {
+        sharded = nowSharded;
+        writtenAreas.clear();
+        watch();
+    }
+
+    // With config.json there is no reading only one area
+    QString only = sharded ? area : QString();
+    bool readSharded = sharded;
+    io->run([readSharded, only]() {
+        return loadFiles(readSharded, only);
+    }, this, [this, readSharded, only, done](const Loaded &loaded) {
+        // The files were split or combined while they were being read, what was read is from the old layout
+        if (readSharded != sharded) {
+            read(only, done);
+            return;
+        }
+        if (!loaded.error.isEmpty()) {
+            done(QJsonObject(), loaded.error);
+            return;
+        }
+
+        if (only.isEmpty()) {
+            merged = loaded.config;
+            if (sharded) {
+                writtenMetadata = loaded.metadata;
+            }
+        } else if (loaded.areaExists) {
+            merged.insert(only, loaded.areaGoals);
+        } else {
+            merged.remove(only);
+        }
+        done(merged, QString());
+    });
+}
+
+ConfigStorage::Loaded ConfigStorage::loadFiles(bool sharded, const QString &area) {
+    Loaded loaded;
+    QJsonDocument document;
+    if (!sharded) {
+        if (readFile(singleFile, document, loaded.error)) {
+            loaded.config = document.object();
+        }
+        return loaded;
+    }
+
+    QDir dir(shardDirectory);
+    if (!area.isEmpty()) {
+        QString path = areaFile(area);
+        loaded.areaExists = QFile::exists(path);
+        if (loaded.areaExists && readFile(path, document, loaded.error)) {
+            loaded.areaGoals = document.array();
+        }
+        return loaded;
+    }
+
+    if (dir.exists(metadataFile)) {
+        if (!readFile(dir.filePath(metadataFile), document, loaded.error)) {
+            return loaded;
+        }
+        loaded.metadata = document.object();
+    }
+    loaded.config = loaded.metadata;
+    for (const QString &file : dir.entryList({"*.json"}, QDir::Files)) {
+        QString fileArea = areaOfFile(file);
+        if (fileArea.isEmpty()) {
+            continue;
+        }
+        if (!readFile(dir.filePath(file), document, loaded.error)) {
+            return loaded;
+        }
+        loaded.config.insert(fileArea, document.array());
+    }
+    return loaded;
+}
+
+void ConfigStorage::write() {
+    if (!sharded) {
+        // There is only the one file
+        writeArea(QString());
+        return;
+    }
+
+    ConfigSnapshotPtr snapshot = goals->publish();
+    for (const QString &area : snapshot->areaNames()) {
+        if (writtenAreas.value(area) != snapshot->area(area)) {
+            writeArea(area);
+        }
+    }
+    writeMetadata();
+}
+
+void ConfigStorage::writeMetadata() {
+    // Only means something with config.d/
+    if (!sharded) {
+        return;
+    }
+
+    // _meta.json changing reloads everything everywhere, so it is only written if it actually changed
+    QJsonObject metadata = goals->publish()->metadataJson();
+    if (metadata == writtenMetadata) {
+        return;
+    }
+    QString path = QDir(shardDirectory).filePath(metadataFile);
+    io->run([path, metadata]() {
+        QString error;
+        writeFile(path, QJsonDocument(metadata), error);
+        return error;
+    }, this, [this, metadata](const QString &error) {
+        if (!error.isEmpty()) {
+            QMessageBox::critical(nullptr, "Error", error);
+            return;
+        }
+        writtenMetadata = metadata;
+    });
+}
+
+void ConfigStorage::writeArea(const QString &area) {
+    // Whatever is newest right now
+    ConfigSnapshotPtr snapshot = goals->publish();
+    bool writeSharded = sharded;
+    QString path = sharded ? areaFile(area) : singleFile;
+
+    io->run([snapshot, writeSharded, area, path]() {
+        // The snapshot doesn't change anymore, so it can be turned into JSON over here as well
+        QJsonDocument document = writeSharded ? QJsonDocument(snapshot->areaToJson(area)) : QJsonDocument(snapshot->toJson());
+        QString error;
+        writeFile(path, document, error);
+        return error;
+    }, this, [this, snapshot, writeSharded, area](const QString &error) {
+        // If unable to write the file show a messagebox with that information
+        if (!error.isEmpty()) {
+            QMessageBox::critical(nullptr, "Error", error);
+            return;
+        }
+        if (writeSharded && sharded) {
+            writtenAreas.insert(area, snapshot->area(area));
+        }
+    });
+}
+
+void ConfigStorage::split(std::function<void(const QString &)> done) {
+    if (sharded) {
+        done("The goals are already split into " + shardDirectory);
+        return;
+    }
+
+    ConfigSnapshotPtr snapshot = goals->publish();
+    io->run([snapshot]() -> QString {
+        // Everything is written to a temporary directory first and that is renamed, so config.d/ is never there half
+        // written (if it were it would be read instead of config.json)
+        QString temporary = shardDirectory + ".new";
+        QDir(temporary).removeRecursively();
+        if (!QDir().mkpath(temporary)) {
+            return "Failed to create " + temporary;
+        }
+
+        for (const QString &area : snapshot->areaNames()) {
+            QFile file(temporary + "/" + QFileInfo(areaFile(area)).fileName());
+            if (!file.open(QIODevice::WriteOnly)) {
+                return "Failed to open file for writing:\n" + file.errorString();
+            }
+            file.write(QJsonDocument(snapshot->areaToJson(area)).toJson());
+            file.close();
+        }
+        QFile metadata(temporary + "/" + metadataFile);
+        if (!metadata.open(QIODevice::WriteOnly)) {
+            return "Failed to open file for writing:\n" + metadata.errorString();
+        }
+        metadata.write(QJsonDocument(snapshot->metadataJson()).toJson());
+        metadata.close();
+
+        if (!QDir().rename(temporary, shardDirectory)) {
+            return "Failed to rename " + temporary + " to " + shardDirectory;
+        }
+
+        // config.json isn't read anymore, it stays as a backup
+        QFile::remove(singleFile + ".bak");
+        QFile::rename(singleFile, singleFile + ".bak");
+        return QString();
+    }, this, [this, snapshot, done](const QString &error) {
+        if (!error.isEmpty()) {
+            done(error);
+            return;
+        }
+
+        sharded = true;
+        merged = snapshot->toJson();
+        writtenMetadata = snapshot->metadataJson();
+        writtenAreas.clear();
+        for (const QString &area : snapshot->areaNames()) {
+            writtenAreas.insert(area, snapshot->area(area));
+        }
+        watch();
+        done(QString());
+    });
+}
+
+void ConfigStorage::combine(std::function<void(const QString &)> done) {
+    if (!sharded) {
+        done("The goals are already in " + singleFile);
+        return;
+    }
+
+    ConfigSnapshotPtr snapshot = goals->publish();
+    io->run([snapshot]() -> QString {
+        QString error;
+        if (!writeFile(singleFile, QJsonDocument(snapshot->toJson()), error)) {
+            return error;
+        }
+
+        // From now on config.json is read, config.d/ is moved out of the way and kept as a backup
+        QDir(shardDirectory + ".bak").removeRecursively();
+        if (!QDir().rename(shardDirectory, shardDirectory + ".bak")) {
+            return "Failed to rename " + shardDirectory + " to " + shardDirectory + ".bak";
+        }
+        return QString();
+    }, this, [this, snapshot, done](const QString &error) {
+        if (!error.isEmpty()) {
+            done(error);
+            return;
+        }
+
+        sharded = false;
+        merged = snapshot->toJson();
+        writtenAreas.clear();
+        watch();
+        done(QString());
+    });
+}
+
+QString ConfigStorage::areaFile(const QString &area) {
+    return shardDirectory + "/" + QString::fromUtf8(QUrl::toPercentEncoding(area)) + ".json";
+}
+
+void ConfigStorage::watch() {
+    QStringList watched = watcher.files() + watcher.directories();
+    if (!watched.isEmpty()) {
+        watcher.removePaths(watched);
+    }
+    areaFiles.clear();
+
+    if (!sharded) {
+        watcher.addPath(singleFile);
+        return;
+    }
+
+    // The directory is watched for area files coming and going, every file for its own changes
+    watcher.addPath(shardDirectory);
+    QDir dir(shardDirectory);
+    for (const QString &file : dir.entryList({"*.json"}, QDir::Files)) {
+        QString path = dir.filePath(file);
+        watcher.addPath(path);
+        if (!areaOfFile(file).isEmpty()) {
+            areaFiles.insert(path);
+        }
+    }
+}
+
+void ConfigStorage::fileChanged(const QString &path) {
+    // Replacing a file (which is how every write happens) can take it out of the watcher, so it is put back
+    if (QFile::exists(path) && !watcher.files().contains(path)) {
+        watcher.addPath(path);
+    }
+
+    if (!sharded || !path.startsWith(shardDirectory + "/")) {
+        emit changed(QString());
+        return;
+    }
+
+    // An area file only reloads its area, _meta.json reloads everything
+    emit changed(areaOfFile(path));
+}
+
+void ConfigStorage::directoryChanged() {
+    // Lock files come and go all the time, only area files showing up or going away matter
+    QSet<QString> current;
+    QDir dir(shardDirectory);
+    if (dir.exists()) {
+        for (const QString &file : dir.entryList({"*.json"}, QDir::Files)) {
+            if (!areaOfFile(file).isEmpty()) {
+                current.insert(dir.filePath(file));
+            }
+        }
+    }
+    if (dir.exists() && current == areaFiles) {
+        return;
+    }
+
+    watch();
+    emit changed(QString());
+}
+
+QString ConfigStorage::areaOfFile(const QString &path) {
+    QString file = QFileInfo(path).fileName();
+    if (!file.endsWith(".json") || file == metadataFile) {
+        return QString();
+    }
+
+    QString area = QUrl::fromPercentEncoding(file.chopped(5).toUtf8());
+    return ConfigSchema::isAreaKey(area) ? area : QString();
+}
+
+bool ConfigStorage::readFile(const QString &path, QJsonDocument &document, QString &error) {
+    // No lock, files are only ever replaced whole (see writeFile) so whatever is there is complete
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = "Failed to open file: " + path;
+        return false;
+    }
+
+    // put the data into a buffer (byte array)
+    QByteArray jsonData = file.readAll();
+    file.close();
+
+    // Try to parse the QByteArray as a jsonDoc
+    QJsonParseError parseError;
+    document = QJsonDocument::fromJson(jsonData, &parseError);
+    if (document.isNull()) {
+        error = "Failed to parse " + path + ": " + parseError.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ConfigStorage::writeFile(const QString &path, const QJsonDocument &document, QString &error) {
+    // No lock. The file is written whole from this instance's goals without reading it first, so a lock wouldn't keep
+    // another instance's change either, it would only decide who writes last. Another instance's write is picked up
+    // through the watcher like always.
+    // Written to a temporary file that replaces the real one once it is complete and flushed, readers never see half a file
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(document.toJson()) < 0 || !file.commit()) {
+        error = "Failed to write " + path + ":\n" + file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,128 @@
+#ifndef CONFIGSTORAGE_H
+#define CONFIGSTORAGE_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QFileSystemWatcher>
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QUrl>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+#include <QMessageBox>
+#include <QDebug>
+
+#include <memory>
+#include <functional>
+
+#include "goalmodel.h"
+#include "retrypolicy.h"
+#include "ioqueue.h"
+
+/*
+ * Where the goals live on disk. There are two layouts:
+ *
+ * - config.json, everything in one file (the way it has always been)
+ * - config.d/, one file per area (config.d/<area>.json holding that area's goals array, the name percent encoded) plus
+ *   config.d/_meta.json for everything that isn't an area. Every file has its own watch, so editing one area only
+ *   rewrites that area's file and only that area is loaded again when its file changes
+ *
+ * config.d/ wins if it exists. split() and combine() move between the two (the menu's import/export), the file that is
+ * left behind is kept next to it as a .bak.
+ *
+ * Writes always take the goals from GoalModel::publish() at the moment they happen. Files are replaced whole through
+ * QSaveFile (a temporary file, flushed, then renamed over the old one), so nobody ever sees half a file and nothing takes
+ * a lock. A write is this instance's goals as a whole, not a read-modify-write, so there's nothing a lock would protect:
+ * the last write wins and the other instances load it through their watchers.
+ *
+ * The reading and writing itself happens on the IoQueue, this object (and everything it keeps track of) stays on the GUI
+ * thread. Results come back through a callback or not at all: a write that fails shows its own error.
+ */
+class ConfigStorage : public QObject
+{
+    Q_OBJECT
+public:
+    static const QString singleFile;
+    static const QString shardDirectory;
+    static const QString metadataFile;
+
+    explicit ConfigStorage(GoalModel *goals, IoQueue *io, QObject *parent = nullptr);
+
+    bool isSharded() const;
+
+    // Reads all of it and calls done with one object shaped like config.json, or with error set if it couldn't be read.
+    // If area is given only that area's file is read again (the area is dropped if its file is gone), in the single file
+    // layout everything is read either way
+    void read(const QString &area, std::function<void(const QJsonObject &config, const QString &error)> done);
+
+    // Writes everything. With config.d/ only the areas that changed since they were last written are
+    void write();
+
+    // Writes area (its file with config.d/, config.json otherwise)
+    void writeArea(const QString &area);
+
+    // config.json -> config.d/, done gets an empty error if it worked
+    void split(std::function<void(const QString &error)> done);
+
+    // config.d/ -> config.json
+    void combine(std::function<void(const QString &error)> done);
+
+    static QString areaFile(const QString &area);
+
+signals:
+    // One area's file changed. area is empty if anything else did (config.json, the metadata, an area file showing up or
+    // going away), then everything should be read again
+    void changed(const QString &area);
+
+private:
+    // What loadFiles() found. With only one area read just areaGoals (and whether the file was there at all) are set
+    struct Loaded
+    {
+        QString error;
+        QJsonObject config;
+        QJsonObject metadata;
+        QJsonArray areaGoals;
+        bool areaExists = false;
+    };
+
+    GoalModel *goals;
+    IoQueue *io;
+    QFileSystemWatcher watcher;
+    bool sharded = false;
+    // The config as it was last read, with config.d/ an area is swapped in on its own when only its file changed
+    QJsonObject merged;
+    // The area files being watched
+    QSet<QString> areaFiles;
+    // What each area file holds as far as this instance knows, so write() can leave the ones that didn't change alone
+    QHash<QString, std::shared_ptr<const ConfigSnapshot::Area>> writtenAreas;
+    QJsonObject writtenMetadata;
+
+    // Writes config.d/_meta.json if it changed since it was last written
+    void writeMetadata();
+
+    void watch();
+
+    void fileChanged(const QString &path);
+
+    void directoryChanged();
+
+    // area's name for one of the files in config.d/, empty if it isn't an area file
+    static QString areaOfFile(const QString &path);
+
+    // Runs on the I/O thread, so it only touches the files and what it's given
+    static Loaded loadFiles(bool sharded, const QString &area);
+
+    // Reads a JSON file, without a lock
+    static bool readFile(const QString &path, QJsonDocument &document, QString &error);
+
+    // Replaces a JSON file atomically. False (with error set) if it couldn't be written
+    static bool writeFile(const QString &path, const QJsonDocument &document, QString &error);
+};
+
+#endif // CONFIGSTORAGE_H
@@ -0,0 +1,291 @@
+#include "ebayapiworker.h"
+
+EbayApiWorker::EbayApiWorker(QObject *parent)
+    : QObject{parent}
+{
+    qRegisterMetaType<EbayOrdersPtr>("EbayOrdersPtr");
+    qRegisterMetaType<EbayMessagesPtr>("EbayMessagesPtr");
+}
+
+void EbayApiWorker::initialize(const QJsonObject &ebayConfigJson) {
+    // Every call to the eBay API goes through this so there is only ever one request per url on the wire
+    requests = new EbayRequestManager(this);
+
+    // GetMyMessages can be big (a full sync), the token call should be quick, everything else gets the default
+    requests->setTimeout("/identity/v1/oauth2/token", 15 * 1000);
+    requests->setTimeout("/sell/fulfillment/v1/order", 30 * 1000);
+    requests->setTimeout("GetMyMessages", 60 * 1000);
+
+    // Only the leader instance talks to eBay, the others render whatever the leader broadcasts
+    election = new EbayLeaderElection(this);
+
+    // Serves the access token from memory and refreshes it before it runs out
+    tokens = new EbayTokenManager(requests, this);
+    tokens->setConfig(ebayConfigJson);
+    QObject::connect(tokens, &EbayTokenManager::writeFailed, this, &EbayApiWorker::errorOccurred);
+
+    // When the leader gets a new token pass it on so a follower that takes over already has it
+    QObject::connect(tokens, &EbayTokenManager::tokenChanged, this, [this](const QString &accessToken, const QDateTime &expiresAt) {
+        election->broadcast(QJsonObject{{"type", "token"}, {"access_token", accessToken}, {"expires_at", expiresAt.toMSecsSinceEpoch()}});
+    });
+
+    // The leader makes the calls right away (this also covers taking over from a leader that exited)
+    QObject::connect(election, &EbayLeaderElection::becameLeader, this, [this]() {
+        tokens->setAutoRefresh(true);
+        emit becameLeader();
+    });
+    QObject::connect(election, &EbayLeaderElection::messageReceived, this, &EbayApiWorker::handleLeaderMessage);
+    election->start();
+}
+
+void EbayApiWorker::fetchOrders(const QString &url) {
+    // Followers get their data from the leader so they never call eBay themselves
+    if (election == nullptr || !election->isLeader()) {
+        return;
+    }
+
+    if (!shouldSend("ebay:orders")) {
+        return;
+    }
+
+    tokens->withToken([this, url](const QString &accessToken) {
+        QNetworkRequest request(QUrl::fromUserInput(url));
+
+        request.setRawHeader("Accept", "application/json");
+        request.setRawHeader("Authorization", "Bearer " + accessToken.toUtf8());
+
+        requests->get(url, request, [this, url](const EbayResponse &response) {
+            handleGetOrders(url, response);
+        });
+
+        qDebug() << "sent GET orders request";
+    });
+}
+
+void EbayApiWorker::fetchMessages(const QString &url) {
+    if (election == nullptr || !election->isLeader()) {
+        return;
+    }
+
+    if (!shouldSend("ebay:messages")) {
+        return;
+    }
+
+    // Normally only ask for what came in since the last poll, every so often get all the headers to catch read flags changing
+    QDateTime endTime = QDateTime::currentDateTimeUtc();
+    bool fullSync = messageStore.needsFullSync(endTime);
+
+    QByteArray window;
+    if (!fullSync) {
+        window = "<StartTime>" + messageStore.windowStart().toUTC().toString(Qt::ISODateWithMs).toUtf8() + "</StartTime>"
+                 "<EndTime>" + endTime.toString(Qt::ISODateWithMs).toUtf8() + "</EndTime>";
+    }
+
+    QByteArray xml_data = R"(
+        <?xml version="1.0" encoding="utf-8"?>
+        <GetMyMessagesRequest xmlns="urn:ebay:apis:eBLBaseComponents">
+            <ErrorLanguage>en_US</ErrorLanguage>
+            <WarningLevel>High</WarningLevel>
+            <DetailLevel>ReturnHeaders</DetailLevel>)" + window + R"(
+        </GetMyMessagesRequest>)";
+
+    // A full call and a windowed call are different requests, so they can't be coalesced into each other
+    QString key = url + (fullSync ? "#full" : "#window");
+
+    tokens->withToken([this, url, key, xml_data, fullSync, endTime](const QString &accessToken) {
+        // The same call is already running (the leader's first refresh and becameLeader's come in right after each other).
+        // Joining it wouldn't work, the chunks only go to the first caller's parser, and its result is the same anyway
+        if (requests->isInFlight(key)) {
+            qDebug() << "GetMyMessages" << (fullSync ? "(full)" : "(window)") << "already running, not sending another";
+            return;
+        }
+
+        QNetworkRequest request( QUrl::fromUserInput(url) );
+
+        request.setRawHeader("X-EBAY-API-SITEID", "0");
+        request.setRawHeader("X-EBAY-API-COMPATIBILITY-LEVEL", "967");
+        request.setRawHeader("X-EBAY-API-CALL-NAME", "GetMyMessages");
+        request.setRawHeader("X-EBAY-API-IAF-TOKEN", accessToken.toUtf8());
+
+        // The headers are parsed while the reply is still coming in
+        std::shared_ptr<EbayMessagesParser> parser = std::make_shared<EbayMessagesParser>();
+        requests->post(key, request, xml_data, [this, url, parser, fullSync, endTime](const EbayResponse &response) {
+            handleGetMessages(url, response, parser, fullSync, endTime);
+        }, [parser](const QByteArray &chunk) {
+            parser->addData(chunk);
+        });
+
+        qDebug() << "Sent POST get Messages request" << (fullSync ? "(full)" : "(window)");
+    });
+}
+
+bool EbayApiWorker::shouldSend(const QString &endpoint) {
+    // A retry with backoff is already lined up, the regular poll doesn't need to add another request to it
+    if (RetryPolicy::shared().isRetryPending(endpoint)) {
+        qDebug() << endpoint << "has a retry pending, skipping this poll";
+        return false;
+    }
+
+    if (!RetryPolicy::shared().allowRequest(endpoint)) {
+        qDebug() << endpoint << "circuit is open, skipping this poll";
+        return false;
+    }
+    return true;
+}
+
+void EbayApiWorker::retryLater(const QString &endpoint, const QString &key, std::function<void()> retry) {
+    // Lets the GUI negative cache the key (the endpoint class is the part after "ebay:")
+    emit requestFailed(key, endpoint.section(':', 1));
+
+    RetryPolicy::shared().failed(endpoint);
+    RetryPolicy::shared().scheduleRetry(endpoint, this, retry);
+}
+
+void EbayApiWorker::reportDiagnostics() {
+    QString report;
+
+    if (requests == nullptr || election == nullptr) {
+        emit diagnosticsReady("The eBay network thread hasn't started yet");
+        return;
+    }
+
+    report += QString("This instance is the eBay ") + (election->isLeader() ? "leader" : "follower (only the leader calls eBay)") + "\n";
+    report += "Requests in flight: " + QString::number(requests->inFlight())
+              + ", coalesced: " + QString::number(requests->coalescedCount()) + "\n\n";
+
+    report += "Latency per endpoint\n";
+    if (requests->latencies().empty()) {
+        report += "  no calls yet\n";
+    }
+    for (const auto &[endpoint, histogram] : requests->latencies()) {
+        report += "  " + endpoint + ": " + histogram.summary() + "\n";
+    }
+
+    QMap<QString, RetryPolicy::Counters> retries = RetryPolicy::shared().counters();
+    report += "\nRetries (" + QString::number(RetryPolicy::shared().totalRetries()) + " total)\n";
+    for (auto it = retries.constBegin(); it != retries.constEnd(); it++) {
+        // Locks that were always free only show up under the lock waits
+        if (it->retries == 0 && it->failures == 0) {
+            continue;
+        }
+        report += "  " + it.key() + ": " + QString::number(it->retries) + " retries, " + QString::number(it->failures) + " failures"
+                  + (it->circuitOpen ? ", circuit open" : "") + "\n";
+    }
+
+    report += "\nLock waits\n";
+    for (auto it = retries.constBegin(); it != retries.constEnd(); it++) {
+        if (it->lockWaits == 0) {
+            continue;
+        }
+        report += "  " + it.key() + ": " + QString::number(it->lockWaits) + " taken, " + QString::number(it->lockTimeouts) + " timed out, "
+                  + QString::number(it->lockWaitMsTotal / it->lockWaits) + " ms average wait, " + QString::number(it->lockWaitMsMax) + " ms longest\n";
+    }
+
+    emit diagnosticsReady(report);
+}
+
+void EbayApiWorker::adoptMessages(EbayMessagesPtr messages) {
+    // Pick up where the cached snapshot left off, so a restart doesn't have to start with a full call
+    messageStore.adopt(*messages);
+}
+
+void EbayApiWorker::handleGetOrders(const QString &key, const EbayResponse &response) {
+    try {
+        qDebug() << key;
+
+        // A newer orders request took over, that one delivers the result
+        if (response.canceled) {
+            return;
+        }
+
+        if (!response.isOk()) {
+            qDebug() << "Error:" << response.errorString;
+            retryLater("ebay:orders", key, [this, key]() {
+                fetchOrders(key);
+            });
+            return;
+        }
+
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(response.body);
+        if (jsonDoc.isNull() || !jsonDoc.isObject()) {
+            qDebug() << "Failed to convert to jsonObject";
+            retryLater("ebay:orders", key, [this, key]() {
+                fetchOrders(key);
+            });
+            return;
+        }
+        RetryPolicy::shared().succeeded("ebay:orders");
+
+        EbayOrdersPtr orders = std::make_shared<const QJsonObject>(jsonDoc.object());
+        emit ordersReady(key, orders, true);
+
+        // Hand the orders to every follower so they don't have to make this call themselves
+        election->broadcast(QJsonObject{{"type", "orders"}, {"data", *orders}});
+    } catch (std::exception err) {
+        qCritical() << err.what();
+    }
+}
+
+void EbayApiWorker::handleGetMessages(const QString &key, const EbayResponse &response, std::shared_ptr<EbayMessagesParser> parser,
+                                      bool fullSync, const QDateTime &endTime) {
+    try {
+        qDebug() << key;
+
+        if (response.canceled) {
+            return;
+        }
+
+        if (!response.isOk()) {
+            qDebug() << "Error:" << response.errorString;
+            retryLater("ebay:messages", key, [this, key]() {
+                fetchMessages(key);
+            });
+            return;
+        }
+
+        EbayMessageList headers = parser->finish();
+        // Don't move the sync point past a response that couldn't be read, the retry covers the same window again
+        if (parser->hasError()) {
+            retryLater("ebay:messages", key, [this, key]() {
+                fetchMessages(key);
+            });
+            return;
+        }
+        RetryPolicy::shared().succeeded("ebay:messages");
+
+        if (fullSync) {
+            messageStore.applyFull(headers, endTime);
+        } else {
+            messageStore.applyWindow(headers, endTime);
+        }
+        qDebug() << headers.size() << "message headers," << (fullSync ? "full sync" : "window");
+
+        EbayMessagesPtr messages = messageStore.snapshot();
+        emit messagesReady(key, messages, true);
+
+        // Followers get the whole store, not the XML, so they never parse it and can carry on the sync if they take over
+        election->broadcast(QJsonObject{{"type", "messages"}, {"data", messages->toJson()}});
+    } catch (std::exception err) {
+        qCritical() << err.what();
+    }
+}
+
+void EbayApiWorker::handleLeaderMessage(const QJsonObject &message) {
+    try {
+        QString type = message.value("type").toString();
+        qDebug() << "received" << type << "from the eBay leader";
+
+        if (type == "orders") {
+            emit ordersReady(QString(), std::make_shared<const QJsonObject>(message.value("data").toObject()), false);
+        } else if (type == "messages") {
+            messageStore.adopt(EbayMessages::fromJson(message.value("data").toObject()));
+            emit messagesReady(QString(), messageStore.snapshot(), false);
+        } else if (type == "token") {
+            // Take the leader's token as is, no need to read ebay.config.json again
+            QDateTime expiresAt = QDateTime::fromMSecsSinceEpoch(message.value("expires_at").toInteger());
+            tokens->setToken(message.value("access_token").toString(), expiresAt);
+        }
+    } catch (std::exception err) {
+        qCritical() << err.what();
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef EBAYAPIWORKER_H
+#define EBAYAPIWORKER_H
+
+#include <QObject>
+
+#include <QNetworkRequest>
+
+#include <QJsonObject>
+#include <QJsonDocument>
+
+#include <QDateTime>
+#include <QDebug>
+
+#include "ebayresults.h"
+#include "ebayrequestmanager.h"
+#include "ebayleaderelection.h"
+#include "ebaytokenmanager.h"
+#include "ebaymessagesparser.h"
+#include "ebaymessagestore.h"
+#include "retrypolicy.h"
+
+/*
+ * Everything that talks to the network for the eBay page: the HTTP requests, the access token and the connection to the
+ * other dashboard instances. It is moved onto its own thread by EbayFrame, so reading replies and parsing the JSON/XML
+ * never happens on the GUI thread. Results go back as immutable objects through queued signals and the GUI only renders them.
+ *
+ * Only call the slots through queued connections/invokeMethod, everything in here belongs to the network thread.
+ */
+class EbayApiWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EbayApiWorker(QObject *parent = nullptr);
+
+public slots:
+    // Creates the network objects, this has to run on the network thread
+    void initialize(const QJsonObject &ebayConfigJson);
+
+    void fetchOrders(const QString &url);
+
+    void fetchMessages(const QString &url);
+
+    // The GUI found messages in the cache, keep the message store in step with them
+    void adoptMessages(EbayMessagesPtr messages);
+
+    // Latency histograms, in flight requests and retry counters as text, sent back through diagnosticsReady
+    void reportDiagnostics();
+
+signals:
+    void becameLeader();
+
+    void errorOccurred(const QString &error);
+
+    // shouldCache is true when the data was just fetched from eBay (not from the cache or the leader)
+    void ordersReady(const QString &key, EbayOrdersPtr orders, bool shouldCache);
+
+    void messagesReady(const QString &key, EbayMessagesPtr messages, bool shouldCache);
+
+    void diagnosticsReady(const QString &report);
+
+    // A call failed (after it was sent), endpointClass is "orders" or "messages"
+    void requestFailed(const QString &key, const QString &endpointClass);
+
+private:
+    EbayRequestManager *requests = nullptr;
+    EbayLeaderElection *election = nullptr;
+    EbayTokenManager *tokens = nullptr;
+    EbayMessageStore messageStore;
+
+    // Retry policy checks for the regular polls, false when a retry is pending or the endpoint's circuit is open
+    bool shouldSend(const QString &endpoint);
+
+    // Count a failure for endpoint and run retry after the backoff
+    void retryLater(const QString &endpoint, const QString &key, std::function<void()> retry);
+
+    void handleGetOrders(const QString &key, const EbayResponse &response);
+
+    void handleGetMessages(const QString &key, const EbayResponse &response, std::shared_ptr<EbayMessagesParser> parser,
+                           bool fullSync, const QDateTime &endTime);
+
+    void handleLeaderMessage(const QJsonObject &message);
+};
+
+#endif // EBAYAPIWORKER_H
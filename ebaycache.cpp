@@ -12,74 +12,229 @@ EbayCache::EbayCache(QObject *parent)
 
     watcher.addPath("ebay.cache.json");
 
-    QObject::connect(&watcher, &QFileSystemWatcher::fileChanged, this, &EbayCache::loadCache);
-
-    timer.start(7 * 1000);
+    // With shared memory the other instances' entries come through there, no need to reparse the file for them
+    QObject::connect(&watcher, &QFileSystemWatcher::fileChanged, this, [this]() {
+        // The file is renamed over on every write, which can drop it from the watcher
+        if (!watcher.files().contains("ebay.cache.json") && QFile::exists("ebay.cache.json")) {
+            watcher.addPath("ebay.cache.json");
+        }
+        if (!shared) {
+            loadCache();
+        }
+    });
 
+    timer.setSingleShot(true);
     QObject::connect(&timer, &QTimer::timeout, this, &EbayCache::checkCacheForExpired);
+    armTimer();
+
+    // Writes happen in the background, one at a time
+    flushPool.setMaxThreadCount(1);
+    flushTimer.setSingleShot(true);
+    QObject::connect(&flushTimer, &QTimer::timeout, this, &EbayCache::flush);
+}
+
+EbayCache::~EbayCache() {
+    // Let a write that is running finish, then write whatever is left so nothing is lost on exit
+    flushPool.waitForDone();
+    if (dirty) {
+        QString error;
+        writeCache(entries, error);
+        if (!error.isEmpty()) {
+            qCritical() << "Failed to write ebay.cache.json on exit" << error;
+        }
+    }
+}
+
+void EbayCache::put(const QString &key, EbayOrdersPtr orders) {
+    insert(key, orders);
+}
+
+void EbayCache::put(const QString &key, EbayMessagesPtr messages) {
+    insert(key, messages);
+}
+
+void EbayCache::setPolicies(const CachePolicies &policies) {
+    this->policies = policies;
 }
 
-QByteArray EbayCache::get(QString key) {
+void EbayCache::setSharedMemoryEnabled(bool enabled) {
+    if (!enabled) {
+        shared.reset();
+        return;
+    }
+    if (shared) {
+        return;
+    }
 
-    if (!cache.contains(key)) {
-        return "";
+    shared = std::make_unique<EbaySharedCache>();
+    if (!shared->attach()) {
+        qDebug() << "eBay shared cache unavailable, using ebay.cache.json only";
+        shared.reset();
+        return;
     }
 
-    QJsonObject item = cache.value(key).toObject();
-    QDateTime expiringTime = QDateTime::fromString(item.value("expires_at").toString(), "ddd MMM d hh:mm:ss yyyy");
-    if (expiringTime < QDateTime::currentDateTime()) {
-        return "";
+    // Whatever was loaded from the file goes in too, the first instance to start fills the segment this way
+    for (auto it = entries.constBegin(); it != entries.constEnd(); it++) {
+        quint32 version = shared->publish(it.key(), it->json, it->expiresAtMs);
+        if (version != 0) {
+            sharedVersions.insert(it.key(), version);
+        }
     }
+}
+
+void EbayCache::syncFromShared(const QString &key) {
+    quint32 version = sharedVersions.value(key, 0);
+    QByteArray payload;
+    if (!shared->read(key, version, payload)) {
+        return;
+    }
+    sharedVersions.insert(key, version);
 
-    if (item.value("data").isString()) {
-        QString jsonString = item.value("data").toString();
-        return jsonString.toUtf8();
+    Entry entry;
+    if (!fromJson(QJsonDocument::fromJson(payload).object(), entry)) {
+        return;
     }
-    QJsonObject jsonObject = item.value("data").toObject();
-    QJsonDocument jsonDoc(jsonObject);
-    return jsonDoc.toJson();
 
+    // Only if it's newer than what is here, the instance that published it also writes it to the file
+    auto it = entries.constFind(key);
+    if (it != entries.constEnd() && it->storedAtMs >= entry.storedAtMs) {
+        return;
+    }
+    entry.lastUsed = ++useClock;
+    entries.insert(key, entry);
+    deadlines.push({entry.expiresAtMs, key});
+    armTimer();
 }
 
-void EbayCache::put(QJsonObject cacheItem, QString key) {
-    QDateTime expiresTime = QDateTime::currentDateTime().addSecs(30);
-    QJsonObject newData = {
-        {"expires_at", expiresTime.toString()},
-        {"data", cacheItem}
-    };
+void EbayCache::putError(const QString &key, const QString &endpointClass) {
+    int negativeSecs = policies.policyFor(endpointClass).negativeSecs;
+    if (negativeSecs > 0) {
+        negative.insert(key, QDateTime::currentMSecsSinceEpoch() + qint64(negativeSecs) * 1000);
+    }
+}
+
+bool EbayCache::failedRecently(const QString &key) const {
+    return negative.value(key, 0) > QDateTime::currentMSecsSinceEpoch();
+}
+
+void EbayCache::insert(const QString &key, Value value) {
+    QString endpointClass = classOf(value);
+    CachePolicy policy = policies.policyFor(endpointClass);
+
+    Entry entry;
+    entry.value = std::move(value);
+    entry.storedAtMs = QDateTime::currentMSecsSinceEpoch();
+    entry.freshUntilMs = entry.storedAtMs + qint64(policy.freshSecs) * 1000;
+    entry.expiresAtMs = entry.storedAtMs + qint64(policy.staleSecs) * 1000;
+    entry.json = QJsonDocument(toJson(entry)).toJson(QJsonDocument::Compact);
+    entry.lastUsed = ++useClock;
+
+    if (entry.json.size() > policy.maxEntryBytes) {
+        qDebug() << "not caching" << key << "," << entry.json.size() << "bytes is over the" << endpointClass << "limit";
+        return;
+    }
+
+    // It worked, so forget about any earlier failure
+    negative.remove(key);
+
+    entries.insert(key, entry);
+    deadlines.push({entry.expiresAtMs, key});
+    evict(endpointClass, key);
+
+    // The other instances see it on their next lookup, without waiting for the file
+    if (shared) {
+        quint32 version = shared->publish(key, entry.json, entry.expiresAtMs);
+        if (version != 0) {
+            sharedVersions.insert(key, version);
+        }
+    }
+
+    armTimer();
+    markDirty();
+}
+
+void EbayCache::evict(const QString &endpointClass, const QString &keepKey) {
+    qint64 budget = policies.policyFor(endpointClass).budgetBytes;
+
+    qint64 used = 0;
+    for (const Entry &entry : entries) {
+        if (classOf(entry.value) == endpointClass) {
+            used += entry.json.size();
+        }
+    }
+
+    // There are only ever a handful of entries, so just look for the oldest one each time
+    while (used > budget) {
+        auto oldest = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); it++) {
+            if (it.key() != keepKey && classOf(it->value) == endpointClass && (oldest == entries.end() || it->lastUsed < oldest->lastUsed)) {
+                oldest = it;
+            }
+        }
+        if (oldest == entries.end()) {
+            break;
+        }
 
-    cache.insert(key, newData);
+        qDebug() << "evicting" << oldest.key() << "to stay in the" << endpointClass << "budget";
+        used -= oldest->json.size();
+        // Its deadline stays in the heap and is skipped when it comes up
+        entries.erase(oldest);
+    }
+}
 
-    saveCache();
+QString EbayCache::classOf(const Value &value) {
+    return std::holds_alternative<EbayOrdersPtr>(value) ? "orders" : "messages";
 }
 
-void EbayCache::put(QByteArray cacheItem, QString key) {
-    QDateTime expiresTime = QDateTime::currentDateTime().addSecs(30);
-    QString data = QString::fromUtf8(cacheItem);
-    QJsonObject newData = {
-        {"expires_at", expiresTime.toString()},
-        {"data", data}
+QJsonObject EbayCache::toJson(const Entry &entry) {
+    QJsonObject json{
+        {"stored_at", entry.storedAtMs},
+        {"fresh_until", entry.freshUntilMs},
+        {"expires_at", entry.expiresAtMs}
     };
 
-    cache.insert(key, newData);
+    if (const EbayOrdersPtr *orders = std::get_if<EbayOrdersPtr>(&entry.value)) {
+        json["type"] = "orders";
+        json["data"] = **orders;
+    } else if (const EbayMessagesPtr *messages = std::get_if<EbayMessagesPtr>(&entry.value)) {
+        json["type"] = "messages";
+        json["data"] = (*messages)->toJson();
+    }
+    return json;
+}
+
+bool EbayCache::fromJson(const QJsonObject &json, Entry &entry) {
+    QJsonValue expiresAt = json.value("expires_at");
+    if (expiresAt.isDouble()) {
+        entry.expiresAtMs = expiresAt.toInteger();
+    } else {
+        // Written by an older version as a date string
+        entry.expiresAtMs = QDateTime::fromString(expiresAt.toString(), "ddd MMM d hh:mm:ss yyyy").toMSecsSinceEpoch();
+    }
 
-    saveCache();
+    // Older entries only had the one time, they were fresh right up to it
+    entry.freshUntilMs = json.contains("fresh_until") ? json.value("fresh_until").toInteger() : entry.expiresAtMs;
+    entry.storedAtMs = json.contains("stored_at") ? json.value("stored_at").toInteger() : entry.freshUntilMs - CachePolicy().freshSecs * 1000;
+    entry.json = QJsonDocument(json).toJson(QJsonDocument::Compact);
+
+    // Entries without a type are from the old format (raw XML strings), they were only good for 30 seconds anyway
+    QString type = json.value("type").toString();
+    if (type == "orders") {
+        entry.value = std::make_shared<const QJsonObject>(json.value("data").toObject());
+        return true;
+    }
+    if (type == "messages") {
+        entry.value = std::make_shared<const EbayMessages>(EbayMessages::fromJson(json.value("data").toObject()));
+        return true;
+    }
+    return false;
 }
 
 void EbayCache::loadCache() {
     try {
-        QLockFile lockFile("ebay.cache.json.lock");
-        lockFile.setStaleLockTime(3000);
-
-        if (!lockFile.tryLock(1000)) {
-            qCritical() << "Failed to accquire lock for ebay.cache.json";
-            return;
-        }
-
-        // open the file
+        // No lock needed, writeCache() replaces the file in one rename so it is always complete
         QFile file("ebay.cache.json");
         if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            lockFile.unlock();
             qCritical() << "Failed to open file: ebay.cache.json";
             return;
         }
@@ -88,7 +243,11 @@ void EbayCache::loadCache() {
         // put the data into a buffer (byte array)
         QByteArray jsonData = file.readAll();
         file.close();
-        lockFile.unlock();
+
+        // The watcher also fires for this instance's own writes, there is nothing new to load from those
+        if (qHash(jsonData) == lastWrittenHash) {
+            return;
+        }
 
         // Try to parse the QByteArray as a jsonDoc
         QJsonParseError error;
@@ -106,70 +265,151 @@ void EbayCache::loadCache() {
             return;
         }
 
-        // Convert the jsonDocument to a jsonObject
+        // Parse every entry once here so lookups never have to
         jsonObj = jsonDoc.object();
-        cache =  jsonObj;
+        QHash<QString, Entry> loaded;
+        DeadlineHeap loadedDeadlines;
+        for (auto it = jsonObj.constBegin(); it != jsonObj.constEnd(); it++) {
+            Entry entry;
+            if (fromJson(it.value().toObject(), entry)) {
+                loaded.insert(it.key(), entry);
+                loadedDeadlines.push({entry.expiresAtMs, it.key()});
+            }
+        }
+
+        // Changes that haven't been written yet would be lost, keep whichever copy of an entry lasts longer
+        if (dirty || flushing) {
+            for (auto it = entries.constBegin(); it != entries.constEnd(); it++) {
+                auto loadedIt = loaded.constFind(it.key());
+                if (loadedIt == loaded.constEnd() || loadedIt->expiresAtMs < it->expiresAtMs) {
+                    loaded.insert(it.key(), it.value());
+                    loadedDeadlines.push({it->expiresAtMs, it.key()});
+                }
+            }
+        }
+
+        entries.swap(loaded);
+        std::swap(deadlines, loadedDeadlines);
+        armTimer();
     } catch (std::exception err) {
         qCritical() << err.what();
     }
 }
 
-void EbayCache::saveCache() {
-    // Create a lockfile
-    QLockFile lockFile("ebay.cache.json.lock");
+void EbayCache::markDirty() {
+    dirty = true;
 
-    // Try to lock said lockfile for 1000 milliseconds .1 second
-    if (!lockFile.tryLock(1000)) {
+    // Everything that changes within the interval goes out in one write
+    if (!flushing && !flushTimer.isActive()) {
+        flushTimer.start(flushIntervalMs);
+    }
+}
 
-        // If it can't access said lock file (somthing else has it locked already try again in 5000 milliseconds
-        QTimer::singleShot(5000, this, [=](){
-            this->saveCache();
-        });
+void EbayCache::flush() {
+    // The write that is running picks up the changes when it is done
+    if (!dirty || flushing) {
         return;
     }
 
-    // Lock was sucssessfull so open the ebay.config.json file and rewrite it
-    QFile file("ebay.cache.json");
-    if (file.open(QIODevice::WriteOnly)) {
-        QJsonDocument jsonDocument(cache);
-        // qDebug() << "JSON document" << jsonDocument.toJson();
-        file.write(jsonDocument.toJson());
-        file.close();
-    } else { // If unable to open the file for writing show a messagebox with that information
-        QMessageBox::critical(nullptr, "Error", "Failed to open file for writing:\n" + file.errorString());
-    }
+    // A copy of the hash only copies pointers (the entries are immutable), so the background write can read it freely
+    QHash<QString, Entry> snapshot = entries;
+    dirty = false;
+    flushing = true;
+
+    flushPool.start([this, snapshot]() {
+        QString error;
+        writeCache(snapshot, error);
 
-    // Unlock the lockfile so something else can access the file at a later point
-    lockFile.unlock();
+        QMetaObject::invokeMethod(this, [this, error]() {
+            flushFinished(error);
+        }, Qt::QueuedConnection);
+    });
 }
 
-void EbayCache::checkCacheForExpired() {
+void EbayCache::flushFinished(const QString &error) {
+    flushing = false;
 
-    try {
-        QStringList keysToRemove;
+    if (!error.isEmpty()) {
+        QMessageBox::critical(nullptr, "Error", error);
+    }
 
-        for (auto it = cache.constBegin(); it != cache.constEnd(); it++) {
-            QString key = it.key();
-            QJsonObject object = cache.value(key).toObject();
-            QString expiringTimeString = object.value("expires_at").toString();
+    if (dirty && !flushTimer.isActive()) {
+        flushTimer.start(flushIntervalMs);
+    }
+}
 
-            QDateTime expiringTimeObj = QDateTime::fromString(expiringTimeString, "ddd MMM d hh:mm:ss yyyy");
-            if (expiringTimeObj <= QDateTime::currentDateTime()) {
-                qDebug() << "removing: " << key;
-                keysToRemove.append(key);
-            }
+void EbayCache::writeCache(const QHash<QString, Entry> &snapshot, QString &error) {
+    // Runs on the flush pool, so it only touches the snapshot and lastWrittenHash
+
+    // Compact, it's only ever read by the dashboard and the indentation was a good part of the file
+    // The entries were serialized when they were added, so this only stitches them together
+    QByteArray data = "{";
+    for (auto it = snapshot.constBegin(); it != snapshot.constEnd(); it++) {
+        if (it != snapshot.constBegin()) {
+            data += ',';
         }
+        // Quoting the key through QJsonDocument takes care of any escaping
+        QByteArray quotedKey = QJsonDocument(QJsonArray{it.key()}).toJson(QJsonDocument::Compact);
+        data += quotedKey.mid(1, quotedKey.size() - 2) + ':' + it->json;
+    }
+    data += '}';
 
-        for (const QString &key : keysToRemove) {
-            cache.remove(key);
+    // No lock: the file is always this instance's whole cache, nothing from the file is merged into it, so a lock would only
+    // decide whose copy lands last. The rename makes sure that whichever it is, it's complete
+
+    // Set before writing so the watcher can never see the change before the hash is there
+    lastWrittenHash = qHash(data);
+
+    // Write a temporary file and rename it over ebay.cache.json once it's flushed
+    QSaveFile file("ebay.cache.json");
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) < 0 || !file.commit()) {
+        // If unable to write the file let the GUI thread show that information
+        error = "Failed to write ebay.cache.json:\n" + file.errorString();
+    }
+}
+
+void EbayCache::checkCacheForExpired() {
+    try {
+        // Only the top of the heap has to be looked at, everything under it expires later
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+        bool removed = false;
+        while (!deadlines.empty() && deadlines.top().first <= now) {
+            Deadline deadline = deadlines.top();
+            deadlines.pop();
+
+            auto it = entries.find(deadline.second);
+            if (it != entries.end() && it->expiresAtMs == deadline.first) {
+                qDebug() << "removing: " << deadline.second;
+                entries.erase(it);
+                removed = true;
+            }
         }
 
-        if (!keysToRemove.isEmpty()) {
-            saveCache();
+        if (removed) {
+            markDirty();
         }
-        timer.start(7 * 1000);
+        armTimer();
     } catch (std::exception err) {
         qCritical() << err.what();
     }
 }
 
+void EbayCache::armTimer() {
+    // Drop deadlines of entries that were replaced or removed since, so the timer isn't armed for nothing
+    while (!deadlines.empty()) {
+        auto it = entries.constFind(deadlines.top().second);
+        if (it != entries.constEnd() && it->expiresAtMs == deadlines.top().first) {
+            break;
+        }
+        deadlines.pop();
+    }
+
+    if (deadlines.empty()) {
+        timer.stop();
+        return;
+    }
+
+    // QTimer takes an int, so anything further out than a day just wakes up once a day to re-arm
+    qint64 msecs = deadlines.top().first - QDateTime::currentMSecsSinceEpoch();
+    timer.start(int(qBound<qint64>(0, msecs, 24 * 60 * 60 * 1000)));
+}
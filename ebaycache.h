@@ -7,30 +7,150 @@
 
 #include <QLockFile>
 #include <QFile>
+#include <QSaveFile>
+#include <QHash>
 
 #include <QMessageBox>
 
 #include <QDateTime>
 #include <QTimer>
 #include <QFileSystemWatcher>
+#include <QThreadPool>
 
+#include <memory>
+#include <variant>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <atomic>
+
+#include "ebayresults.h"
+#include "cachepolicy.h"
+#include "retrypolicy.h"
+#include "ebaysharedcache.h"
+
+/*
+ * Keeps the results of eBay calls for a short while so they aren't requested again on every refresh.
+ * Entries are held already parsed (the same immutable objects the network thread hands over), so a hit is just a
+ * shared_ptr copy. ebay.cache.json is only there so the cache survives restarts and is shared with the other instances,
+ * it is read when it changes and written behind: changes only mark the cache dirty and one background write per
+ * interval saves all of them (this instance's own writes don't trigger a reload either).
+ *
+ * How long entries stay fresh/stale, how big they may get and the byte budget per class (orders, messages) come from the
+ * CachePolicies table. Once a class goes over its budget the least recently used entries are dropped. Failed calls are
+ * remembered for a while too (negative caching) so a failing endpoint isn't asked again on every refresh.
+ *
+ * Every entry is fresh for a short while and then stale until a much longer limit. Stale entries are still handed out
+ * (flagged as stale) so the panels can show them straight away while a new copy is fetched, and they survive restarts.
+ *
+ * Expiry times are epoch milliseconds in a min-heap, and a single-shot timer is armed for whichever entry runs out first
+ * (nothing wakes up at all while the cache is empty).
+ *
+ * With the shared memory tier turned on (see EbaySharedCache) new entries are also published to the other instances
+ * through shared memory, and lookups pick up their newer versions from there. The file is then only read at startup.
+ */
 class EbayCache : public QObject
 {
     Q_OBJECT
 public:
     explicit EbayCache(QObject *parent = nullptr);
 
+    ~EbayCache();
+
+    template <typename T>
+    struct Hit
+    {
+        std::shared_ptr<const T> value;
+        // Past its freshness TTL, show it but fetch a new copy
+        bool stale = false;
+        qint64 storedAtMs = 0;
+
+        explicit operator bool() const { return value != nullptr; }
+    };
+
+    // Empty if there is no entry of that type for the key (or it is past the stale limit), T is QJsonObject (orders) or EbayMessages
+    template <typename T>
+    Hit<T> get(const QString &key);
+
+    void put(const QString &key, EbayOrdersPtr orders);
+    void put(const QString &key, EbayMessagesPtr messages);
+
+    void setPolicies(const CachePolicies &policies);
 
-    QByteArray get(QString key);
-    void put(QJsonObject cacheItem, QString key);
-    void put(QByteArray cacheItem, QString key);
+    // Turns the shared memory tier on, stays off if the segment can't be set up
+    void setSharedMemoryEnabled(bool enabled);
+
+    // Remember that the call for key failed, for the negative TTL of its class
+    void putError(const QString &key, const QString &endpointClass);
+
+    // True while a failure for key is remembered, the call shouldn't be made again until then
+    bool failedRecently(const QString &key) const;
 
 private:
-    QJsonObject cache;
+    using Value = std::variant<EbayOrdersPtr, EbayMessagesPtr>;
+
+    struct Entry
+    {
+        Value value;
+        qint64 storedAtMs = 0;
+        qint64 freshUntilMs = 0;
+        // The stale limit, the entry is removed after this
+        qint64 expiresAtMs = 0;
+        // The entry as it goes into ebay.cache.json, made once when the entry is added. It's also what the size is measured by
+        QByteArray json;
+        // For the LRU eviction, bumped on every hit
+        mutable qint64 lastUsed = 0;
+    };
+
+    // (deadline, key) with the earliest deadline on top. Replacing an entry leaves its old deadline in here, those are
+    // skipped when they come up because they no longer match the entry
+    using Deadline = std::pair<qint64, QString>;
+    using DeadlineHeap = std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>>;
+
+    static const int flushIntervalMs = 2000;
+
+    CachePolicies policies;
+    QHash<QString, Entry> entries;
+    // Failed calls and until when they are remembered, this only lives in memory
+    QHash<QString, qint64> negative;
+    mutable qint64 useClock = 0;
+    DeadlineHeap deadlines;
     QFileSystemWatcher watcher;
     QTimer timer;
+    QTimer flushTimer;
+    QThreadPool flushPool;
+    bool dirty = false;
+    bool flushing = false;
+    // Hash of the last bytes this instance wrote, written on the flush thread and read by loadCache()
+    std::atomic<size_t> lastWrittenHash{0};
+    std::unique_ptr<EbaySharedCache> shared;
+    // The version of each key's shared slot this instance already has
+    QHash<QString, quint32> sharedVersions;
 
-    void saveCache();
+    void armTimer();
+
+    // Drops the least recently used entries of a class until it fits its byte budget again (never keepKey)
+    void evict(const QString &endpointClass, const QString &keepKey);
+
+    static QString classOf(const Value &value);
+
+    void markDirty();
+
+    void flush();
+
+    void flushFinished(const QString &error);
+
+    // Replaces ebay.cache.json with the snapshot, error is set if the file couldn't be written
+    void writeCache(const QHash<QString, Entry> &snapshot, QString &error);
+
+    void insert(const QString &key, Value value);
+
+    // Takes the entry for key from shared memory if another instance published a newer one
+    void syncFromShared(const QString &key);
+
+    static QJsonObject toJson(const Entry &entry);
+
+    static bool fromJson(const QJsonObject &json, Entry &entry);
 
 private slots:
     void loadCache();
@@ -39,4 +159,27 @@ private slots:
 signals:
 };
 
+template <typename T>
+EbayCache::Hit<T> EbayCache::get(const QString &key) {
+    Hit<T> hit;
+    if (shared) {
+        syncFromShared(key);
+    }
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    auto it = entries.constFind(key);
+    if (it == entries.constEnd() || it->expiresAtMs < now) {
+        return hit;
+    }
+
+    const std::shared_ptr<const T> *value = std::get_if<std::shared_ptr<const T>>(&it->value);
+    if (value != nullptr) {
+        hit.value = *value;
+        hit.stale = now >= it->freshUntilMs;
+        hit.storedAtMs = it->storedAtMs;
+        it->lastUsed = ++useClock;
+    }
+    return hit;
+}
+
 #endif // EBAYCACHE_H
@@ -1,13 +1,11 @@
 #include "ebayframe.h"
 
-EbayFrame::EbayFrame(QJsonObject* configJson, QWidget *parent)
+EbayFrame::EbayFrame(GoalModel* goals, ConfigStorage* storage, IoQueue* io, QWidget *parent)
     : QWidget{parent}
 {
-    this->configJson = configJson;
-
-    manager = nullptr;
-
-    httpCallLock = new QLockFile("http.call.lock");
+    this->goals = goals;
+    this->storage = storage;
+    this->io = io;
 
     // Color for the frames (gray slightly blue ish)
     QColor frameColor(203, 203, 213);
@@ -15,7 +13,7 @@ EbayFrame::EbayFrame(QJsonObject* configJson, QWidget *parent)
     this->ordersFrame = new EbayOrdersFrame(frameColor, this);
     this->messagesFrame = new EbayMessagesFrame(frameColor, this);
     this->infoFrame = new EbayInfoFrame(frameColor, this);
-    this->goalsFrame = new EbayGoalsFrame(frameColor, configJson, this);
+    this->goalsFrame = new EbayGoalsFrame(frameColor, goals, storage, this);
     this->cache = new EbayCache(this);
 
     // Set the margins on the outside of the grid of areas to be 0 (I do this so the layout can then define margins)
@@ -52,25 +50,56 @@ EbayFrame::EbayFrame(QJsonObject* configJson, QWidget *parent)
         qDebug() << err.what();
     }
 
-    QObject::connect(this, &EbayFrame::refreshFinished, this, &EbayFrame::handleRefresh);
-    QObject::connect(this, &EbayFrame::replyFinished, this, &EbayFrame::handleResponse);
-    QObject::connect(this, &EbayFrame::getOrdersFinished, this, &EbayFrame::handleGetOrders);
-    QObject::connect(this, &EbayFrame::getMessagesFinished, this, &EbayFrame::handleGetMessages);
+    cache->setPolicies(CachePolicies::fromConfig(ebayConfigJson));
+    cache->setSharedMemoryEnabled(ebayConfigJson.value("eBay").toObject().value("shared_memory_cache").toBool(false));
 
+    try {
+        loadSales();
+    } catch (std::runtime_error err) {
+        qDebug() << err.what();
+    }
+    infoFrame->setAnalytics(&salesAnalytics);
 
     repopulate();
 
-    refreshAccessToken();
-
+    // All of the networking and parsing happens on its own thread, this thread only renders what comes back
+    worker = new EbayApiWorker;
+    worker->moveToThread(&networkThread);
+    QObject::connect(&networkThread, &QThread::finished, worker, &QObject::deleteLater);
+
+    // The worker lives on another thread so these are queued connections
+    QObject::connect(worker, &EbayApiWorker::becameLeader, this, &EbayFrame::refreshData);
+    QObject::connect(worker, &EbayApiWorker::ordersReady, this, &EbayFrame::handleOrders);
+    QObject::connect(worker, &EbayApiWorker::messagesReady, this, &EbayFrame::handleMessages);
+    QObject::connect(worker, &EbayApiWorker::errorOccurred, this, [](const QString &error) {
+        QMessageBox::critical(nullptr, "Error", error);
+    });
+    QObject::connect(worker, &EbayApiWorker::requestFailed, this, [this](const QString &key, const QString &endpointClass) {
+        cache->putError(key, endpointClass);
+    });
+    QObject::connect(worker, &EbayApiWorker::diagnosticsReady, this, [this](const QString &report) {
+        QMessageBox::information(this, "eBay Diagnostics", report);
+    });
+
+    networkThread.setObjectName("eBay network");
+    networkThread.start();
+
+    QJsonObject ebayConfig = ebayConfigJson;
+    QMetaObject::invokeMethod(worker, [worker = worker, ebayConfig]() {
+        worker->initialize(ebayConfig);
+    }, Qt::QueuedConnection);
+
+    // Put whatever the cache has (even stale) on screen right away instead of waiting for the first round trip.
+    // The election is usually won inside initialize(), so by the time these fetches run this instance is already the leader
+    // and they go out; becameLeader's refresh then finds them in flight. A follower's fetches are ignored
+    refreshData();
+}
 
-    // if (hasLock || httpCallLock->tryLock(1000)) {
-    //     hasLock = true;
-    //     refreshAccessToken();
-    // } else {
-    //     QTimer::singleShot(5000, this, [=](){
-    //         this->refreshAccessToken();
-    //     });
-    // }
+void EbayFrame::showDiagnostics() {
+    // The numbers live on the network thread, the worker sends them back as text
+    QMetaObject::invokeMethod(worker, [worker = worker]() {
+        worker->reportDiagnostics();
+    }, Qt::QueuedConnection);
 }
 
 void EbayFrame::repopulate() {
@@ -81,7 +110,7 @@ void EbayFrame::repopulate() {
 }
 
 void EbayFrame::repopulateGoals() {
-    goalsFrame->repopulate();
+    goalsFrame->refresh();
 }
 
 void EbayFrame::darkMode() {
@@ -124,312 +153,194 @@ void EbayFrame::loadJson() {
     }
 }
 
-void EbayFrame::getAwaitingShipments() {
-    qDebug() << "geting awating shipments";
-
-    QDateTime dateTime = QDateTime::currentDateTime();
-    qint64 month = dateTime.date().month() -1;
-    qint64 year = dateTime.date().year();
-    if (month == 0 ) { // January is 1 but we try to reduce it by one so make it 12
-        month = 12;
-        year -= 1;
+void EbayFrame::loadSales() {
+    // There is no file until the first orders come in
+    QFile file("ebay.sales.json");
+    if (!file.exists()) {
+        return;
     }
-    dateTime.setDate(QDate(year, month, 1));
-    dateTime.setTime(QTime::fromMSecsSinceStartOfDay(0));
-
-    QString url = "https://api.ebay.com/sell/fulfillment/v1/order?filter=creationdate:%5B"+dateTime.toString("yyyy-MM-ddTHH:mm:ss.zzzZ") + "..%5D&limit=200&fieldGroups=TAX_BREAKDOWN";
-
-    QByteArray byteArray = cache->get(url);
-    if (byteArray != "") {
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(byteArray);
-        if (jsonDoc.isObject()) {
-            QJsonObject cachedItem = jsonDoc.object();
-            if (!cachedItem.isEmpty()) {
-                ordersFrame->setOrdersJson(&cachedItem);
-                ordersFrame->repopulate();
-
-                infoFrame->setOrdersJson(&cachedItem);
-                infoFrame->repopulate();
-                return;
-            }
-        }
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw std::runtime_error("Failed to open ebay.sales.json");
     }
 
-    if (hasLock || httpCallLock->tryLock(1000)) {
-        hasLock = true;
+    QByteArray jsonData = file.readAll();
+    file.close();
 
-        QNetworkRequest request(QUrl::fromUserInput(url));
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData, &error);
+    if (jsonDoc.isNull()) {
+        QString err = "Failed to parse ebay.sales.json:" + error.errorString();
+        throw std::runtime_error(err.toStdString());
+    }
 
-        request.setRawHeader("Accept", "application/json");
-        request.setRawHeader("Authorization", "Bearer " + ebayConfigJson["eBay"].toObject()["access_token"].toString().toUtf8());
+    salesAnalytics = EbaySalesAnalytics::fromJson(jsonDoc.object());
+}
 
-        if (manager == nullptr) {
-            manager = new QNetworkAccessManager(this);
-        }
+void EbayFrame::saveSales() {
+    // Serialized here, the analytics keep changing as orders come in. The writing happens on the I/O thread
+    QByteArray data = QJsonDocument(salesAnalytics.toJson()).toJson(QJsonDocument::Compact);
 
-        replyMap[url] = manager->get(request);
+    io->run([data]() {
+        IoQueue::WriteResult result;
 
-        QObject::connect(replyMap[url], &QNetworkReply::finished, this, [this, url]() {
-            emit getOrdersFinished(url);
-        });
+        // Create a lockfile, only for the writers (loadSales() reads whatever is there, it's always a whole file)
+        QLockFile lockFile("ebay.sales.json.lock");
+        if (!RetryPolicy::shared().tryLock(lockFile, "lock:ebay.sales.json")) {
+            result.locked = false;
+            return result;
+        }
 
-        qDebug() << "sent GET orders request";
+        QSaveFile file("ebay.sales.json");
+        if (!file.open(QIODevice::WriteOnly) || file.write(data) < 0 || !file.commit()) {
+            result.error = "Failed to write ebay.sales.json:\n" + file.errorString();
+        }
 
-    } else {
-        QTimer::singleShot(5000, this, [=](){
-            this->getAwaitingShipments();
-        });
-    }
+        lockFile.unlock();
+        return result;
+    }, this, [this](const IoQueue::WriteResult &result) {
+        if (!result.locked) {
+            // If it can't access said lock file (somthing else has it locked already) try again after a backoff
+            RetryPolicy::shared().scheduleRetry("lock:ebay.sales.json", this, [=](){
+                this->saveSales();
+            });
+            return;
+        }
+        RetryPolicy::shared().succeeded("lock:ebay.sales.json");
 
+        // If unable to write the file show a messagebox with that information
+        if (!result.error.isEmpty()) {
+            QMessageBox::critical(nullptr, "Error", result.error);
+        }
+    });
 }
 
-void EbayFrame::refreshAccessToken() {
-    qDebug() << "refreshing access token";
+void EbayFrame::getAwaitingShipments() {
+    qDebug() << "geting awating shipments";
 
-    QString expiringTime = ebayConfigJson.value("eBay").toObject().value("expires_at").toString();
-    QDateTime expiringObj = QDateTime::fromString(expiringTime, "ddd MMM d hh:mm:ss yyyy");
-    QDateTime now = QDateTime::currentDateTime();
-    if (now <= expiringObj) {
-        getAwaitingShipments();
-        getMessages();
-        return;
+    QDateTime dateTime = QDateTime::currentDateTime();
+    qint64 month = dateTime.date().month() -1;
+    qint64 year = dateTime.date().year();
+    if (month == 0 ) { // January is 1 but we try to reduce it by one so make it 12
+        month = 12;
+        year -= 1;
     }
+    dateTime.setDate(QDate(year, month, 1));
+    dateTime.setTime(QTime::fromMSecsSinceStartOfDay(0));
 
-    if (hasLock || httpCallLock->tryLock(1000)) {
-        hasLock = true;
-
-        QString url = "https://api.ebay.com/identity/v1/oauth2/token";
-        QNetworkRequest request(QUrl::fromUserInput(url));
-
-        QString credentials = ebayConfigJson.value("eBay").toObject().value("client_ID").toString() + ":";
-        credentials += ebayConfigJson.value("eBay").toObject().value("client_secret").toString();
-
-        QByteArray base64Credentials = credentials.toUtf8().toBase64();
-
-        request.setRawHeader("Content-Type", "application/x-www-form-urlencoded");
-        request.setRawHeader("Authorization", "Basic " + base64Credentials);
-
-        QByteArray data = "grant_type=refresh_token";
-        data.append('&');
-        data.append("refresh_token=" + ebayConfigJson.value("eBay").toObject().value("refresh_token").toString().toUtf8());
+    QString url = ebayApiBaseUrl(ebayConfigJson) + "/sell/fulfillment/v1/order?filter=creationdate:%5B"+dateTime.toString("yyyy-MM-ddTHH:mm:ss.zzzZ") + "..%5D&limit=200&fieldGroups=TAX_BREAKDOWN";
 
-        if (manager == nullptr) {
-            manager = new QNetworkAccessManager(this);
+    // The cache holds the parsed orders, so a hit goes straight to the panels. A stale hit is shown too (flagged as stale)
+    // and then revalidated below, the request manager makes sure only one revalidation is ever running
+    EbayCache::Hit<QJsonObject> cached = cache->get<QJsonObject>(url);
+    if (cached) {
+        showOrders(cached.value, cached.stale ? cached.storedAtMs : 0);
+        if (!cached.stale) {
+            return;
         }
+    }
 
-        replyMap[url] = manager->post(request, data);
+    // This call failed a moment ago, don't ask again until the negative TTL is over (the worker retries on its own backoff)
+    if (cache->failedRecently(url)) {
+        qDebug() << "orders failed recently, not asking again yet";
+        return;
+    }
 
-        QObject::connect(replyMap[url], &QNetworkReply::finished, this, [this, url]() {
-            emit refreshFinished(url);
-        });
+    QMetaObject::invokeMethod(worker, [worker = worker, url]() {
+        worker->fetchOrders(url);
+    }, Qt::QueuedConnection);
+}
 
-        qDebug() << "Sent POST refresh request";
+void EbayFrame::refreshData() {
+    // Start to finish time of a refresh, this is what to look at when running against the mock server
+    refreshClock.start();
 
-    } else {
-        QTimer::singleShot(5000, this, [=](){
-            this->loadJson();
-            this->refreshAccessToken();
-        });
-    }
+    // The worker's token manager hands out the cached token (or holds the calls until a refresh finishes) so just ask for the data
+    getAwaitingShipments();
+    getMessages();
 }
 
 
 void EbayFrame::getMessages() {
     qDebug() << "getting messages";
 
-    QByteArray xml_data = R"(
-        <?xml version="1.0" encoding="utf-8"?>
-        <GetMyMessagesRequest xmlns="urn:ebay:apis:eBLBaseComponents">
-            <ErrorLanguage>en_US</ErrorLanguage>
-            <WarningLevel>High</WarningLevel>
-            <DetailLevel>ReturnHeaders</DetailLevel>
-        </GetMyMessagesRequest>)";
-
-
-    QString url = "https://api.ebay.com/ws/api.dll";
-
-    QByteArray cachedItem = cache->get(url);
-
-    if (cachedItem != "") {
-        messagesFrame->setConfig(cachedItem);
-        messagesFrame->repopulate();
-        return;
-    }
-
-    if (hasLock || httpCallLock->tryLock(1000)) {
-        hasLock = true;
+    QString url = ebayApiBaseUrl(ebayConfigJson) + "/ws/api.dll";
 
-        QNetworkRequest request( QUrl::fromUserInput(url) );
+    EbayCache::Hit<EbayMessages> cached = cache->get<EbayMessages>(url);
+    if (cached) {
+        showMessages(cached.value, cached.stale ? cached.storedAtMs : 0);
 
-        request.setRawHeader("X-EBAY-API-SITEID", "0");
-        request.setRawHeader("X-EBAY-API-COMPATIBILITY-LEVEL", "967");
-        request.setRawHeader("X-EBAY-API-CALL-NAME", "GetMyMessages");
-        request.setRawHeader("X-EBAY-API-IAF-TOKEN", ebayConfigJson["eBay"].toObject()["access_token"].toString().toUtf8());
+        QMetaObject::invokeMethod(worker, [worker = worker, messages = cached.value]() {
+            worker->adoptMessages(messages);
+        }, Qt::QueuedConnection);
 
-        if (manager == nullptr) {
-            manager = new QNetworkAccessManager(this);
+        if (!cached.stale) {
+            return;
         }
-
-        replyMap[url] = manager->post(request, xml_data);
-
-        QObject::connect(replyMap[url], &QNetworkReply::finished, this, [this, url]() {
-            emit getMessagesFinished(url);
-        });
-
-        qDebug() << "Sent POST get Messages request";
-
-    } else {
-        QTimer::singleShot(5000, this, [=](){
-            this->getMessages();
-        });
     }
 
-}
-
-void EbayFrame::rewriteJson() {
-    // Create a lockfile
-    QLockFile lockFile("ebay.config.json.lock");
-
-    // Try to lock said lockfile for 1000 milliseconds .1 second
-    if (!lockFile.tryLock(1000)) {
-
-        // If it can't access said lock file (somthing else has it locked already try again in 5000 milliseconds
-        QTimer::singleShot(5000, this, [=](){
-            this->rewriteJson();
-        });
+    if (cache->failedRecently(url)) {
+        qDebug() << "messages failed recently, not asking again yet";
         return;
     }
 
-    // Lock was sucssessfull so open the ebay.config.json file and rewrite it
-    QFile file("ebay.config.json");
-    if (file.open(QIODevice::WriteOnly)) {
-        QJsonDocument jsonDocument(ebayConfigJson);
-        file.write(jsonDocument.toJson());
-        file.close();
-    } else { // If unable to open the file for writing show a messagebox with that information
-        QMessageBox::critical(nullptr, "Error", "Failed to open file for writing:\n" + file.errorString());
-    }
-
-    // Unlock the lockfile so something else can access the file at a later point
-    lockFile.unlock();
+    QMetaObject::invokeMethod(worker, [worker = worker, url]() {
+        worker->fetchMessages(url);
+    }, Qt::QueuedConnection);
 }
 
-void EbayFrame::handleResponse(const QString &key) {
-    try {
-        qDebug() << key;
-
+void EbayFrame::showOrders(EbayOrdersPtr orders, qint64 staleSinceMs) {
+    // A cache hit hands back the same object every refresh, only a new response has to be parsed into the store
+    if (orders != shownOrders) {
+        shownOrders = orders;
+        orderStore = std::make_shared<const EbayOrderStore>(EbayOrderStore::fromJson(*orders));
 
-        if (replyMap[key]->error() != QNetworkReply::NoError) {
-            qDebug() << "Error:" << replyMap[key]->errorString();
-        } else {
-            QByteArray responseData = replyMap[key]->readAll();
-            qDebug() << "Response:" << responseData;
+        // Only orders that are new or changed since the last response touch the totals
+        if (salesAnalytics.ingest(*orderStore)) {
+            saveSales();
         }
-
-        replyMap[key]->deleteLater();
-        replyMap.remove(key);
-        checkManager();
-    } catch (std::exception err) {
-        qCritical() << err.what();
     }
 
-}
-
-void EbayFrame::handleGetOrders(const QString &key) {
-    try {
-        qDebug() << key;
-
-        if (replyMap[key]->error() != QNetworkReply::NoError) {
-            qDebug() << "Error:" << replyMap[key]->errorString();
-        } else {
-            QByteArray responseData = replyMap[key]->readAll();
-
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(responseData);
-
-            if (!jsonDoc.isNull() && jsonDoc.isObject()) {
-                ordersJson = jsonDoc.object();
-
-            } else {
-                qDebug() << "Failed to convert to jsonObject";
-            }
-        }
+    if (refreshClock.isValid()) {
+        qDebug() << "eBay orders rendered" << refreshClock.elapsed() << "ms after the refresh started" << (staleSinceMs != 0 ? "(stale)" : "");
+    }
 
-        replyMap[key]->deleteLater();
-        replyMap.remove(key);
+    ordersFrame->setOrders(orderStore);
+    ordersFrame->setStaleSince(staleSinceMs);
+    ordersFrame->repopulate();
 
-        ordersFrame->setOrdersJson(&ordersJson);
-        ordersFrame->repopulate();
+    infoFrame->setStaleSince(staleSinceMs);
+    infoFrame->repopulate();
+}
 
-        infoFrame->setOrdersJson(&ordersJson);
-        infoFrame->repopulate();
+void EbayFrame::showMessages(EbayMessagesPtr messages, qint64 staleSinceMs) {
+    messagesFrame->setMessages(messages);
+    messagesFrame->setStaleSince(staleSinceMs);
+    messagesFrame->repopulate();
 
-        cache->put(ordersJson, key);
-        checkManager();
-    } catch (std::exception err) {
-        qCritical() << err.what();
+    if (refreshClock.isValid()) {
+        qDebug() << "eBay messages rendered" << refreshClock.elapsed() << "ms after the refresh started" << (staleSinceMs != 0 ? "(stale)" : "");
     }
 }
 
-void EbayFrame::handleRefresh(const QString &key) {
+void EbayFrame::handleOrders(const QString &key, EbayOrdersPtr orders, bool shouldCache) {
     try {
-        qDebug() << key;
-
-        if (replyMap[key]->error() != QNetworkReply::NoError) {
-            qDebug() << "Error:" << replyMap[key]->errorString();
-        } else {
-            QByteArray responseData = replyMap[key]->readAll();
-
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(responseData);
-
-            if (!jsonDoc.isNull() && jsonDoc.isObject()) {
-                QJsonObject jsonObject = jsonDoc.object();
-
-                QJsonObject configCopy = ebayConfigJson["eBay"].toObject();
-                configCopy["access_token"] = jsonObject["access_token"].toString();
-
-                QDateTime expiringTime = QDateTime::currentDateTime();
-                qint64 expires_in = jsonObject.value("expires_in").toInteger();
-                expiringTime = expiringTime.addSecs(expires_in - 100);
-                configCopy["expires_at"] = expiringTime.toString();
-
-                ebayConfigJson["eBay"] = configCopy;
-
-                rewriteJson();
-                getAwaitingShipments();
-                getMessages();
-            } else {
-                qDebug() << "Failed to convert to jsonObject";
-            }
+        showOrders(orders, 0);
 
+        if (shouldCache) {
+            cache->put(key, orders);
         }
-
-        replyMap[key]->deleteLater();
-        replyMap.remove(key);
-        checkManager();
     } catch (std::exception err) {
         qCritical() << err.what();
     }
 }
 
-void EbayFrame::handleGetMessages(const QString &key) {
+void EbayFrame::handleMessages(const QString &key, EbayMessagesPtr messages, bool shouldCache) {
     try {
-        qDebug() << key;
-
-        if (replyMap[key]->error() != QNetworkReply::NoError) {
-            qDebug() << "Error:" << replyMap[key]->errorString();
-        } else {
-            QByteArray responseData = replyMap[key]->readAll();
-
-            messagesFrame->setConfig(responseData);
-            messagesFrame->repopulate();
-
-            cache->put(responseData, key);
+        showMessages(messages, 0);
 
+        if (shouldCache) {
+            cache->put(key, messages);
         }
-
-        replyMap[key]->deleteLater();
-        replyMap.remove(key);
-        checkManager();
     } catch (std::exception err) {
         qCritical() << err.what();
     }
@@ -438,22 +349,11 @@ void EbayFrame::handleGetMessages(const QString &key) {
 void EbayFrame::timerTimeout() {
     try {
         qDebug() << "timer finished";
-        // By calling refreshAccessToken all other http calling functions will also be called
-        refreshAccessToken();
-
         refreshTimer.start(60 * 1000);
+
+        // Followers are ignored by the worker, they get their data from the leader
+        refreshData();
     } catch (std::exception err) {
         qCritical() << err.what();
     }
 }
-
-void EbayFrame::checkManager() {
-    if (!hasLock) {
-        return;
-    }
-    if (manager->children().isEmpty()) {
-        manager->deleteLater();
-        hasLock = false;
-        httpCallLock->unlock();
-    }
-}
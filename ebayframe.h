@@ -3,14 +3,12 @@
 
 #include <QWidget>
 
-#include <QNetworkAccessManager>
-#include <QNetworkRequest>
-#include <QNetworkReply>
-#include <QHash>
+#include <QThread>
 
 #include <QGridLayout>
 
 #include <QFile>
+#include <QSaveFile>
 #include <QLockFile>
 #include <QTimer>
 
@@ -18,6 +16,7 @@
 #include <QJsonDocument>
 
 #include <QDateTime>
+#include <QElapsedTimer>
 
 #include <QMessageBox>
 #include <QDebug>
@@ -28,23 +27,31 @@
 #include "ebayinfoframe.h"
 #include "ebaygoalsframe.h"
 #include "ebaycache.h"
+#include "ebayapiworker.h"
+#include "ebaysalesanalytics.h"
+#include "retrypolicy.h"
+#include "ioqueue.h"
 
 class EbayFrame : public QWidget
 {
     Q_OBJECT
 
 private:
-    QNetworkAccessManager *manager;
-    QHash<QString, QNetworkReply*> replyMap;
+    QThread networkThread;
+    EbayApiWorker *worker;
     QGridLayout layout;
     QJsonObject ebayConfigJson;
-    QJsonObject ordersJson;
-    QJsonObject* configJson;
+    // The orders that are showing, and the parsed store built from them (rebuilt only when the orders change)
+    EbayOrdersPtr shownOrders;
+    EbayOrderStorePtr orderStore;
+    EbaySalesAnalytics salesAnalytics;
+    GoalModel* goals;
+    ConfigStorage* storage;
+    IoQueue* io;
     QJsonObject historyJson;
     bool isDarkMode = false;
-    bool hasLock = false;
-    QLockFile *httpCallLock;
     QTimer refreshTimer;
+    QElapsedTimer refreshClock;
 
     EbayOrdersFrame* ordersFrame;
     EbayMessagesFrame* messagesFrame;
@@ -54,54 +61,44 @@ private:
 
     void loadJson();
 
-    void refreshAccessToken();
+    // The sales history lives in ebay.sales.json, it only ever grows past what the orders call returns
+    void loadSales();
+    void saveSales();
+
+    void refreshData();
     void getAwaitingShipments();
 
     void getMessages();
 
+    // Put the data in the panels, staleSinceMs is when stale data was fetched (0 for fresh data)
+    void showOrders(EbayOrdersPtr orders, qint64 staleSinceMs);
+
+    void showMessages(EbayMessagesPtr messages, qint64 staleSinceMs);
+
 public:
-    explicit EbayFrame(QJsonObject* configJson, QWidget *parent = nullptr);
+    explicit EbayFrame(GoalModel* goals, ConfigStorage* storage, IoQueue* io, QWidget *parent = nullptr);
 
     ~EbayFrame() {
-        for (auto it = replyMap.begin(); it != replyMap.end(); it++) {
-            it.value()->deleteLater();
-        }
-        if (hasLock) {
-            httpCallLock->unlock();
-            manager->deleteLater();
-        }
+        // Stop the network thread, the worker (and every request it still has running) is deleted as the thread finishes
+        networkThread.quit();
+        networkThread.wait();
         layout.deleteLater();
-        delete httpCallLock;
     }
 
     void repopulate();
 
+    // Only renders the goals again if the eBay area changed since they were last rendered
     void repopulateGoals();
 
     void darkMode();
 
-    void rewriteJson();
-
-    void checkManager();
-
-signals:
-    void refreshFinished(const QString &key);
-
-    void replyFinished(const QString &key);
-
-    void getOrdersFinished(const QString &key);
-
-    void getMessagesFinished(const QString &key);
+    void showDiagnostics();
 
 private slots:
-    void handleResponse(const QString  &key);
-
-    void handleRefresh(const QString &key);
-
-    void handleGetOrders(const QString &key);
+    void timerTimeout();
 
-    void handleGetMessages(const QString &key);
+    void handleOrders(const QString &key, EbayOrdersPtr orders, bool shouldCache);
 
-    void timerTimeout();
+    void handleMessages(const QString &key, EbayMessagesPtr messages, bool shouldCache);
 };
 #endif // EBAYFRAME_H
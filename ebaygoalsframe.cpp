@@ -1,9 +1,10 @@
 #include "ebaygoalsframe.h"
 
-EbayGoalsFrame::EbayGoalsFrame(const QColor& color, QJsonObject* configJson, QWidget* parent)
+EbayGoalsFrame::EbayGoalsFrame(const QColor& color, GoalModel* goals, ConfigStorage* storage, QWidget* parent)
     : QWidget{parent}
 {
-    this->configJson = configJson;
+    this->goals = goals;
+    this->storage = storage;
     this->color = color;
     this->name = "eBay";
 
@@ -70,32 +71,15 @@ void EbayGoalsFrame::repopulate() {
 }
 
 
-void EbayGoalsFrame::rewriteJson(){
-    // Create a lockfile
-    QLockFile lockFile("config.json.lock");
-
-    // Try to lock said lockfile for 1000 milliseconds .1 second
-    if (!lockFile.tryLock(1000)) {
-
-        // If it can't access said lock file (somthing else has it locked already try again in 5000 milliseconds
-        QTimer::singleShot(5000, this, [=](){
-            this->rewriteJson();
-        });
-        return;
-    }
-
-    // Lock was sucssessfull so open the config.json file and rewrite it
-    QFile file("config.json");
-    if (file.open(QIODevice::WriteOnly)) {
-        QJsonDocument jsonDocument(*configJson);
-        file.write(jsonDocument.toJson());
-        file.close();
-    } else { // If unable to open the file for writing show a messagebox with that information
-        QMessageBox::critical(nullptr, "Error", "Failed to open file for writing:\n" + file.errorString());
+void EbayGoalsFrame::refresh() {
+    if (goals->snapshot()->area(name) != renderedArea) {
+        repopulate();
     }
+}
 
-    // Unlock the lockfile so something else can access the file at a later point
-    lockFile.unlock();
+void EbayGoalsFrame::rewriteJson(){
+    // Just the eBay goals, the other areas are left alone
+    storage->writeArea(name);
 }
 
 
@@ -150,11 +134,8 @@ QString EbayGoalsFrame::getCSS() {
     }
 
     QString width = "50%";
-    if (configJson->value("eBay").isArray()) {
-        qint64 numEbayGoals = configJson->value("eBay").toArray().count();
-        if (numEbayGoals == 3) {
-            width = "33.33%";
-        }
+    if (goals->snapshot()->goalCount("eBay") == 3) {
+        width = "33.33%";
     }
 
 
@@ -176,35 +157,32 @@ QString EbayGoalsFrame::getBody() {
     // Add the area name as the title as well as a line underneath the title
     html += "<body><h1>" + name + "</h1>" + "<hr>";
 
-    // Add each goal
-    int i = 0;
-    if (configJson->value(name).isArray()) {
-
-    QJsonArray areaArray = configJson->value(name).toArray();
-        html += "<div class='goalsContainer'>";
-        foreach (const QJsonValue &value, areaArray) {
-            if (value.isObject()) {
-                QJsonObject goal = value.toObject();
-
-                QString goalName = goal.value("name").toString();
-                QString targetValue = goal.value("target_value").toString();
-                QString currentValue = goal.value("current_value").toString();
-                QString endDate = goal.value("end_date").toString();
-                QString goalNum = QString::number(i);
-
-                html += "<div class='goalBox'>" ;
-                html += "<h3 id='title_" + goalNum + "'>" + goalName + "</h3>"
-                        "<div>"
-                            "Target: <span id='targetValue_" + goalNum +"'>" + targetValue + "</span> <br>"
-                            "<span id='progressLabel_" + goalNum + "'> Current Progress: " + "<input type='text'  value='" + currentValue + "' id='" + goalNum + "'>"
-                                "<button type='button' class='button_" + goalNum +"' onclick='handleButton(" + goalNum + ", 1)'>+</button>"
-                                "<button type='button' class='button_" + goalNum +"' onclick='handleButton(" + goalNum + ", -1)'>–</button> </span><br>"
-                            "<span id='finishLabel_" + goalNum + "'> Finish By: <span id='endDate_" + goalNum +"'>" + endDate + "</span> </span> <br>"
-                        "</div>";
-                html += "</div>";
-                i++;
-            }
-        }
+    // Add each goal, soonest end date first. The page numbers them in that order and renderedIds maps the numbers back
+    // Render from one snapshot
+    ConfigSnapshotPtr snapshot = goals->snapshot();
+    renderedArea = snapshot->area(name);
+    renderedIds.clear();
+    html += "<div class='goalsContainer'>";
+    for (const Goal *goal : snapshot->ordered(name)) {
+        QString goalName = goal->name;
+        QString targetValue = goal->targetValue;
+        QString currentValue = goal->currentValue;
+        // The page gets the date formatted along with whether it is due so it never parses dates itself
+        QDate end = goal->endDate;
+        QString endDate = end.isValid() ? end.toString() : goal->extra.value("end_date").toString();
+        QString goalNum = QString::number(renderedIds.size());
+        renderedIds.append(goal->id);
+
+        html += "<div class='goalBox'>" ;
+        html += "<h3 id='title_" + goalNum + "'>" + goalName + "</h3>"
+                "<div>"
+                    "Target: <span id='targetValue_" + goalNum +"'>" + targetValue + "</span> <br>"
+                    "<span id='progressLabel_" + goalNum + "'> Current Progress: " + "<input type='text'  value='" + currentValue + "' id='" + goalNum + "'>"
+                        "<button type='button' class='button_" + goalNum +"' onclick='handleButton(" + goalNum + ", 1)'>+</button>"
+                        "<button type='button' class='button_" + goalNum +"' onclick='handleButton(" + goalNum + ", -1)'>–</button> </span><br>"
+                    "<span id='finishLabel_" + goalNum + "' data-due='" + ConfigSchema::dueClass(end) + "'> Finish By: <span id='endDate_" + goalNum +"'>" + endDate + "</span> </span> <br>"
+                "</div>";
+        html += "</div>";
     }
     html += "</div>";
 
@@ -213,132 +191,104 @@ QString EbayGoalsFrame::getBody() {
 
 QString EbayGoalsFrame::getGoalsScript() {
     QString html = "";
-    if (configJson->value(name).isArray()) {
-        QJsonArray areaArray = configJson->value(name).toArray();
-
-        for (qint64 j=0; j<areaArray.size(); j++) {
-            QString goalNum = QString::number(j);
-            QString name = "inputField" + goalNum;
-            html += "var " + name + " = document.getElementById('" + goalNum + "');"
-                    + name + ".addEventListener('keydown', function(event) {"
-                             "if (event.keyCode === 13) {"
-                             "var inputValue = " + name + ".value;"
-                             "channel.objects.qtBridge.inputSubmitted(inputValue, " + goalNum + ");"
-                                "}"
-                                "});";
-
-            html += "var progressLabel = document.getElementById('progressLabel_" + goalNum + "');"
-                                                                                              "var finishLabel = document.getElementById('finishLabel_" + goalNum + "');"
-                                "var inputValue = document.getElementById('" + goalNum + "').value;"
-                                "var targetValue = parseFloat(document.getElementById('targetValue_" + goalNum + "').innerText);"
-                                "var endDateString = document.getElementById('endDate_" + goalNum + "').innerText;"
-                                "var endDate = new Date(endDateString);"
-                                ""
-                                "var currentValue = parseFloat(inputValue);"
-                                ""
-                                "var today = new Date();"
-                                "today.setHours(0, 0, 0, 0);"
-                                "endDate.setHours(0, 0, 0, 0);"
-                                ""
-                                "if (currentValue >= targetValue) {"
-                                "progressLabel.style.color = 'green';"
-                                "} else {"
-                                "if (today.getMonth() === 3 && today.getDate() === 1) {"
-                                "progressLabel.style.color = 'white';"
-                                "} else {"
-                                "if (isDarkMode == false) {"
-                                "progressLabel.style.color = 'black';"
-                                "} else {"
-                                "progressLabel.style.color = 'white';"
-                                "}"
-                                "}"
-                                "}"
-                                "if (endDate < today) {"
-                                "finishLabel.style.color = 'red';"
-                                "} else if (endDate.getTime() === today.getTime()) {"
-                                "finishLabel.style.color = '#8B4000';"
-                                "} else {"
-                                "if (today.getMonth() === 3 && today.getDate() === 1) {"
-                                "progressLabel.style.color = 'white';"
-                                "} else {"
-                                "if (isDarkMode == false) {"
-                                "progressLabel.style.color = 'black';"
-                                "} else {"
-                                "progressLabel.style.color = 'white';"
-                                "}"
-                                "}"
-                                "}"
-                                ""
-                                "if (today.getMonth() === 3 && today.getDate() === 1) {"
-                                "document.body.style.color = 'white';"
-                                "} else {"
-                                "if (isDarkMode == false) {"
-                                "document.body.style.color = 'black';"
-                                "} else {"
-                                "document.body.style.color = 'white';"
-                                "}"
-                                "}";
-
-
-            // check if the current progress is a number. if it is not remove the two buttons (the plus and minus button because if they were pressed the information would be lost)
-            html += "var buttons_" + goalNum + "= document.getElementsByClassName('button_" + goalNum + "');"
-                    + name + ".addEventListener('input', function() {"
-                             "if (isNaN(" + name + ".value) || " + name + ".value === '') {"
-                                                    "for (var button of buttons_" + goalNum + ") {"
-                                "button.style.display = 'none';"
-                                "}"
-                                "} else {"
-                                "for (var button of buttons_" + goalNum + ") {"
-                                "button.style.display = 'inline-block';"
-                                "}"
-                                "}"
-                                "});";
-
-            // At the start of the page load, check if the buttons should be hidden
-            html += "document.addEventListener('DOMContentLoaded', function() {"
-                    "if (isNaN(" + name + ".value) || " + name + ".value === '') {"
-                                                    "for (var button of buttons_" + goalNum + ") {"
-                                "button.style.display = 'none';"
-                                "}"
-                                "}"
-                                "});";
+    for (qint64 j=0; j<renderedIds.size(); j++) {
+        QString goalNum = QString::number(j);
+        QString name = "inputField" + goalNum;
+        html += "var " + name + " = document.getElementById('" + goalNum + "');"
+                + name + ".addEventListener('keydown', function(event) {"
+                         "if (event.keyCode === 13) {"
+                         "var inputValue = " + name + ".value;"
+                         "channel.objects.qtBridge.inputSubmitted(inputValue, " + goalNum + ");"
+                            "}"
+                            "});";
+
+        html += "var progressLabel = document.getElementById('progressLabel_" + goalNum + "');"
+                                                                                          "var finishLabel = document.getElementById('finishLabel_" + goalNum + "');"
+                            "var inputValue = document.getElementById('" + goalNum + "').value;"
+                            "var targetValue = parseFloat(document.getElementById('targetValue_" + goalNum + "').innerText);"
+                            ""
+                            "var currentValue = parseFloat(inputValue);"
+                            ""
+                            "var today = new Date();"
+                            "today.setHours(0, 0, 0, 0);"
+                            ""
+                            "if (currentValue >= targetValue) {"
+                            "progressLabel.style.color = 'green';"
+                            "} else {"
+                            "if (today.getMonth() === 3 && today.getDate() === 1) {"
+                            "progressLabel.style.color = 'white';"
+                            "} else {"
+                            "if (isDarkMode == false) {"
+                            "progressLabel.style.color = 'black';"
+                            "} else {"
+                            "progressLabel.style.color = 'white';"
+                            "}"
+                            "}"
+                            "}"
+                            "if (finishLabel.dataset.due === 'overdue') {"
+                            "finishLabel.style.color = 'red';"
+                            "} else if (finishLabel.dataset.due === 'today') {"
+                            "finishLabel.style.color = '#8B4000';"
+                            "} else {"
+                            "if (today.getMonth() === 3 && today.getDate() === 1) {"
+                            "progressLabel.style.color = 'white';"
+                            "} else {"
+                            "if (isDarkMode == false) {"
+                            "progressLabel.style.color = 'black';"
+                            "} else {"
+                            "progressLabel.style.color = 'white';"
+                            "}"
+                            "}"
+                            "}"
+                            ""
+                            "if (today.getMonth() === 3 && today.getDate() === 1) {"
+                            "document.body.style.color = 'white';"
+                            "} else {"
+                            "if (isDarkMode == false) {"
+                            "document.body.style.color = 'black';"
+                            "} else {"
+                            "document.body.style.color = 'white';"
+                            "}"
+                            "}";
+
+
+        // check if the current progress is a number. if it is not remove the two buttons (the plus and minus button because if they were pressed the information would be lost)
+        html += "var buttons_" + goalNum + "= document.getElementsByClassName('button_" + goalNum + "');"
+                + name + ".addEventListener('input', function() {"
+                         "if (isNaN(" + name + ".value) || " + name + ".value === '') {"
+                                                "for (var button of buttons_" + goalNum + ") {"
+                            "button.style.display = 'none';"
+                            "}"
+                            "} else {"
+                            "for (var button of buttons_" + goalNum + ") {"
+                            "button.style.display = 'inline-block';"
+                            "}"
+                            "}"
+                            "});";
+
+        // At the start of the page load, check if the buttons should be hidden
+        html += "document.addEventListener('DOMContentLoaded', function() {"
+                "if (isNaN(" + name + ".value) || " + name + ".value === '') {"
+                                                "for (var button of buttons_" + goalNum + ") {"
+                            "button.style.display = 'none';"
+                            "}"
+                            "}"
+                            "});";
 
-        }
     }
 
     return html;
 }
 
 void EbayGoalsFrame::inputSubmitted(const QString &input, const QString goalNumber) {
-    // Get this area's goals
-    QString targetValue;
-    if (configJson->value(name).isArray()) {
-        QJsonArray goalsArray = configJson->value(name).toArray();
-
-        int i = 0;
-        for (auto&& goal : goalsArray){ // Iterate over the goals
-
-            // If i is equal to the goalNumber as an int
-            if (i == goalNumber.toInt()) {
-                // Convert that copy of the goal to be an object
-                QJsonObject goalObj = goal.toObject();
-                // Set the current value of the goal to be the submitted value
-                goalObj["current_value"] = input;
-
-                // Save the target value (this is only used for the funny box)
-                targetValue = goalObj["target_value"].toString();
-
-                // Set the goal to be the copy with changed current value
-                goal = goalObj;
-                break;
-            }
-            // Increase i
-            i++;
-        }
-        // Set the this area's goals to be the edited array
-        (*configJson)[this->name] = goalsArray;
+    // Find which goal the page means and set its current value to be the submitted value
+    int position = goalNumber.toInt();
+    if (position < 0 || position >= renderedIds.size() || !goals->setCurrentValue(renderedIds[position], input)) {
+        return;
     }
 
+    // Save the target value (this is only used for the funny box)
+    QString targetValue = goals->find(renderedIds[position])->targetValue;
 
 
     // Create a message box saying that the information was submitted that closes automatically in 1 second
@@ -379,6 +329,3 @@ void EbayGoalsFrame::darkMode() {
     repopulate();
 }
 
-void EbayGoalsFrame::setJson(QJsonObject* configJson) {
-    this->configJson = configJson;
-}
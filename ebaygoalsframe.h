@@ -18,11 +18,16 @@
 #include <QFile>
 #include <QLockFile>
 
+#include "retrypolicy.h"
+#include "configschema.h"
+#include "goalmodel.h"
+#include "configstorage.h"
+
 class EbayGoalsFrame : public QWidget
 {
     Q_OBJECT
 public:
-    explicit EbayGoalsFrame(const QColor& color, QJsonObject* configJson, QWidget* parent = nullptr);
+    explicit EbayGoalsFrame(const QColor& color, GoalModel* goals, ConfigStorage* storage, QWidget* parent = nullptr);
 
     ~EbayGoalsFrame(){
         emit aboutToClose();
@@ -34,9 +39,10 @@ public:
 
     void repopulate();
 
-    void darkMode();
+    // repopulate() if the eBay goals aren't the ones on the page anymore
+    void refresh();
 
-    void setJson(QJsonObject* configJson);
+    void darkMode();
 
 private:
     QString name;
@@ -44,7 +50,12 @@ private:
     QWebEngineView webEngine;
     QVBoxLayout layout;
     QWebChannel *channel;
-    QJsonObject* configJson;
+    GoalModel* goals;
+    ConfigStorage* storage;
+    // The id of each goal on the page, the page numbers its goals 0, 1, 2... in the order they are shown
+    QVector<QString> renderedIds;
+    // The eBay area of the snapshot the page was rendered from
+    std::shared_ptr<const ConfigSnapshot::Area> renderedArea;
     bool isDarkMode = false;
 
     void rewriteJson();
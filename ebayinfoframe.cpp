@@ -4,7 +4,7 @@ EbayInfoFrame::EbayInfoFrame(const QColor& color, QWidget* parent)
     : QWidget{parent}
 {
     this->configJson = nullptr;
-    this->ordersJson = nullptr;
+    this->analytics = nullptr;
     this->color = color;
 
     layout.addWidget(&webEngine);
@@ -24,12 +24,39 @@ void EbayInfoFrame::repopulate() {
 
     html += "<body>";
 
-    QPair<qint64, qint64> numOrders = calculateSoldItems();
-
-    html += "<h3>Num orders past 7 days</h3>";
-    html += "<h4>" + QString::number(numOrders.second) + "</h4>";
-    html += "<h3>Num orders this month</h3>";
-    html += "<h4>" + QString::number(numOrders.first) + "</h4>";
+    // Stale data is shown right away while the new copy is on its way, just say how old it is
+    html += StaleBanner::html(staleSinceMs);
+
+    if (analytics != nullptr) {
+        // Every one of these is a prefix sum lookup, nothing is recounted here
+        EbaySalesAnalytics::Totals week = analytics->lastDays(7);
+        EbaySalesAnalytics::Totals month = analytics->monthToDate();
+
+        html += "<h3>Num orders past 7 days</h3>";
+        html += "<h4>" + QString::number(week.orders) + "</h4>";
+        html += "<h3>Num orders this month</h3>";
+        html += "<h4>" + QString::number(month.orders) + "</h4>";
+
+        html += "<table class='sales'><tr><th></th><th>Orders</th><th>Units</th><th>Gross</th><th>Tax</th><th>Fees</th></tr>";
+        html += totalsRow("7 days", week);
+        html += totalsRow("30 days", analytics->lastDays(30));
+        html += totalsRow("90 days", analytics->lastDays(90));
+        html += totalsRow("This month", month);
+
+        // Only compare against last year once the history actually reaches back that far
+        QDate today = QDate::currentDate();
+        if (analytics->covers(QDate(today.year() - 1, today.month(), 1))) {
+            EbaySalesAnalytics::Totals lastYear = analytics->monthToDateLastYear();
+            html += totalsRow("Last year", lastYear);
+            html += "</table>";
+            if (lastYear.grossCents != 0) {
+                double change = 100.0 * (month.grossCents - lastYear.grossCents) / lastYear.grossCents;
+                html += "<h5>Gross vs. this point last year: " + QString(change >= 0 ? "+" : "") + QString::number(change, 'f', 1) + "%</h5>";
+            }
+        } else {
+            html += "</table>";
+        }
+    }
 
     html += "</body></html>";
 
@@ -38,38 +65,21 @@ void EbayInfoFrame::repopulate() {
     return;
 }
 
-void EbayInfoFrame::setOrdersJson(QJsonObject* ordersJson) {
-    this->ordersJson = ordersJson;
+void EbayInfoFrame::setAnalytics(const EbaySalesAnalytics* analytics) {
+    this->analytics = analytics;
 }
 
-QPair<qint64, qint64> EbayInfoFrame::calculateSoldItems() {
-    if (ordersJson == nullptr) {
-        return QPair<qint64, qint64>(0,0);
-    }
+QString EbayInfoFrame::totalsRow(const QString &label, const EbaySalesAnalytics::Totals &totals) {
+    return "<tr><td>" + label + "</td>"
+           "<td>" + QString::number(totals.orders) + "</td>"
+           "<td>" + QString::number(totals.units) + "</td>"
+           "<td>" + formatCents(totals.grossCents) + "</td>"
+           "<td>" + formatCents(totals.taxCents) + "</td>"
+           "<td>" + formatCents(totals.feeCents) + "</td></tr>";
+}
 
-    if (!ordersJson->value("orders").isArray()) {
-        return QPair<qint64, qint64>(0,0);
-    }
-    QJsonArray ordersArray = ordersJson->value("orders").toArray();
-    qint64 weeksOrders = 0;
-    qint64 monthsOrders = 0;
-    QDate today = QDate::currentDate();
-    QDate firstOfMonth = QDate(today.year(), today.month(), 1);
-    for (auto&& order : ordersArray) {
-        QJsonObject orderObj = order.toObject();
-        QString creationDateString = orderObj.value("creationDate").toString();
-        QDateTime creationDateTime = QDateTime::fromString(creationDateString, Qt::ISODate);
-        QDate creationDate = creationDateTime.date();
-
-
-        if (creationDate >= today.addDays(-7)) {
-            weeksOrders++;
-        }
-        if (creationDate >= firstOfMonth ) {
-            monthsOrders++;
-        }
-    }
-    return QPair<qint64, qint64>(monthsOrders, weeksOrders);
+QString EbayInfoFrame::formatCents(qint64 cents) {
+    return "$" + QString::number(cents / 100.0, 'f', 2);
 }
 
 QString EbayInfoFrame::getCSS() {
@@ -127,12 +137,20 @@ QString EbayInfoFrame::getCSS() {
                "input[type='text'] { margin-right: 5px; font-size: 5vmin; width: 9em;}"
                "button { margin-right: 2.5px; font-weight: bold;  font-size: 5vmin;}"
                ".goalsContainer { width: 100%; }"
+               + StaleBanner::css() +
+               ".sales { margin: 0 auto; font-size: 0.55em; border-collapse: collapse; }"
+               ".sales td, .sales th { padding: 0 0.4em; text-align: right; }"
+               "h5 { text-align: center; font-size: 0.6em; }"
                "</style>";
 
 
     return styling;
 }
 
+void EbayInfoFrame::setStaleSince(qint64 msecsSinceEpoch) {
+    staleSinceMs = msecsSinceEpoch;
+}
+
 void EbayInfoFrame::darkMode() {
     isDarkMode = !isDarkMode;
     repopulate();
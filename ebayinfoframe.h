@@ -8,6 +8,10 @@
 
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QDateTime>
+
+#include "ebaysalesanalytics.h"
+#include "stalebanner.h"
 
 class EbayInfoFrame : public QWidget
 {
@@ -17,19 +21,27 @@ public:
 
     void repopulate();
 
-    void setOrdersJson(QJsonObject* ordersJson);
+    // Owned by the EbayFrame, which outlives this panel
+    void setAnalytics(const EbaySalesAnalytics* analytics);
 
     void darkMode();
 
+    // When the data shown was fetched, if it is stale (0 when it is fresh)
+    void setStaleSince(qint64 msecsSinceEpoch);
+
 private:
-    QJsonObject* ordersJson;
+    const EbaySalesAnalytics* analytics;
     QJsonObject* configJson;
     QWebEngineView webEngine;
     QVBoxLayout layout;
     QColor color;
     bool isDarkMode = false;
+    qint64 staleSinceMs = 0;
+
+    // One row of the sales table
+    static QString totalsRow(const QString &label, const EbaySalesAnalytics::Totals &totals);
 
-    QPair<qint64, qint64> calculateSoldItems();
+    static QString formatCents(qint64 cents);
 
     QString getCSS();
 
@@ -0,0 +1,169 @@
+#include "ebayleaderelection.h"
+
+namespace {
+const QString serverName = "goalsDashboard.ebay.leader";
+}
+
+EbayLeaderElection::EbayLeaderElection(QObject *parent)
+    : QObject{parent}, leaseFile{"ebay.leader.lock"}
+{
+    // The lease is only stale when the process holding it is gone, never because of its age
+    leaseFile.setStaleLockTime(0);
+}
+
+EbayLeaderElection::~EbayLeaderElection() {
+    if (leader) {
+        server->close();
+        leaseFile.unlock();
+    }
+}
+
+void EbayLeaderElection::start() {
+    runElection();
+}
+
+bool EbayLeaderElection::isLeader() const {
+    return leader;
+}
+
+void EbayLeaderElection::broadcast(const QJsonObject &message) {
+    if (!leader) {
+        return;
+    }
+
+    QByteArray line = encode(message);
+    latestMessages[message.value("type").toString()] = line;
+
+    for (QLocalSocket *follower : followers) {
+        follower->write(line);
+    }
+}
+
+void EbayLeaderElection::runElection() {
+    if (leader) {
+        return;
+    }
+
+    // Whoever gets the lease without waiting becomes the leader, everyone else follows
+    if (leaseFile.tryLock(0)) {
+        becomeLeader();
+    } else {
+        connectToLeader();
+    }
+}
+
+void EbayLeaderElection::scheduleElection() {
+    // Wait a random amount of time so the followers of a leader that just exited don't all race for the lease at once
+    int delay = QRandomGenerator::global()->bounded(250, 1500);
+    QTimer::singleShot(delay, this, [=](){
+        this->runElection();
+    });
+}
+
+void EbayLeaderElection::becomeLeader() {
+    if (leaderSocket != nullptr) {
+        leaderSocket->disconnect(this);
+        leaderSocket->abort();
+        leaderSocket->deleteLater();
+        leaderSocket = nullptr;
+    }
+
+    // A leader that crashed can leave its socket behind, we hold the lease so it is safe to remove
+    QLocalServer::removeServer(serverName);
+
+    server = new QLocalServer(this);
+    if (!server->listen(serverName)) {
+        qCritical() << "Failed to start eBay leader server:" << server->errorString();
+        server->deleteLater();
+        server = nullptr;
+        leaseFile.unlock();
+        scheduleElection();
+        return;
+    }
+
+    QObject::connect(server, &QLocalServer::newConnection, this, &EbayLeaderElection::acceptFollowers);
+
+    leader = true;
+    qDebug() << "this instance is now the eBay leader";
+    emit becameLeader();
+}
+
+void EbayLeaderElection::connectToLeader() {
+    if (leaderSocket != nullptr) {
+        return;
+    }
+
+    QLocalSocket *socket = new QLocalSocket(this);
+    leaderSocket = socket;
+    readBuffer.clear();
+
+    QObject::connect(socket, &QLocalSocket::connected, this, [this]() {
+        qDebug() << "following the eBay leader";
+        emit becameFollower();
+    });
+
+    QObject::connect(socket, &QLocalSocket::readyRead, this, &EbayLeaderElection::readFromLeader);
+
+    // Both a leader that exited and a leader that isn't listening (yet) end up here, either way run the election again
+    auto dropLeader = [this, socket]() {
+        if (leaderSocket != socket) {
+            return;
+        }
+        leaderSocket = nullptr;
+        socket->deleteLater();
+        scheduleElection();
+    };
+    QObject::connect(socket, &QLocalSocket::disconnected, this, dropLeader);
+    QObject::connect(socket, &QLocalSocket::errorOccurred, this, [socket, dropLeader](QLocalSocket::LocalSocketError error) {
+        if (socket->state() == QLocalSocket::ConnectedState) {
+            return;
+        }
+        qDebug() << "could not reach the eBay leader:" << error;
+        dropLeader();
+    });
+
+    socket->connectToServer(serverName, QIODevice::ReadOnly);
+}
+
+void EbayLeaderElection::acceptFollowers() {
+    while (server->hasPendingConnections()) {
+        QLocalSocket *follower = server->nextPendingConnection();
+        followers.append(follower);
+
+        QObject::connect(follower, &QLocalSocket::disconnected, this, [this, follower]() {
+            followers.removeOne(follower);
+            follower->deleteLater();
+        });
+
+        // Catch the new follower up with the newest message of every type
+        for (const QByteArray &line : latestMessages) {
+            follower->write(line);
+        }
+    }
+}
+
+void EbayLeaderElection::readFromLeader() {
+    readBuffer.append(leaderSocket->readAll());
+
+    qsizetype newline = readBuffer.indexOf('\n');
+    while (newline != -1) {
+        QByteArray line = readBuffer.left(newline);
+        readBuffer.remove(0, newline + 1);
+
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(line);
+        if (jsonDoc.isObject()) {
+            emit messageReceived(jsonDoc.object());
+        } else {
+            qDebug() << "ignoring malformed message from the eBay leader";
+        }
+
+        newline = readBuffer.indexOf('\n');
+    }
+}
+
+QByteArray EbayLeaderElection::encode(const QJsonObject &message) {
+    // Compact JSON never contains a newline so it can be used to separate messages
+    QByteArray line = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    return line;
+}
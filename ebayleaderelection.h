@@ -0,0 +1,75 @@
+#ifndef EBAYLEADERELECTION_H
+#define EBAYLEADERELECTION_H
+
+#include <QObject>
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QLockFile>
+
+#include <QJsonObject>
+#include <QJsonDocument>
+
+#include <QList>
+#include <QMap>
+#include <QTimer>
+#include <QRandomGenerator>
+
+#include <QDebug>
+
+/*
+ * Makes sure only one dashboard process on this machine talks to eBay.
+ * The instance that holds the leader lease (a QLockFile that is kept for as long as the process is the leader) opens a
+ * QLocalServer. Every other instance connects to it as a follower and receives whatever the leader broadcasts.
+ * If the leader exits the followers lose their connection and run the election again, so one of them takes over.
+ *
+ * Messages are compact JSON objects, one per line. Every message has a "type" and the leader remembers the newest
+ * message of each type so a follower that connects late is caught up immediately.
+ */
+class EbayLeaderElection : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EbayLeaderElection(QObject *parent = nullptr);
+
+    ~EbayLeaderElection();
+
+    void start();
+
+    bool isLeader() const;
+
+    // Send a message to every follower (only does something while this instance is the leader)
+    void broadcast(const QJsonObject &message);
+
+signals:
+    void becameLeader();
+
+    void becameFollower();
+
+    void messageReceived(const QJsonObject &message);
+
+private:
+    QLockFile leaseFile;
+    QLocalServer *server = nullptr;
+    QLocalSocket *leaderSocket = nullptr;
+    QList<QLocalSocket*> followers;
+    QMap<QString, QByteArray> latestMessages;
+    QByteArray readBuffer;
+    bool leader = false;
+
+    void runElection();
+
+    void scheduleElection();
+
+    void becomeLeader();
+
+    void connectToLeader();
+
+    void acceptFollowers();
+
+    void readFromLeader();
+
+    static QByteArray encode(const QJsonObject &message);
+};
+
+#endif // EBAYLEADERELECTION_H
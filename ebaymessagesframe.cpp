@@ -3,7 +3,6 @@
 EbayMessagesFrame::EbayMessagesFrame(const QColor& color, QWidget* parent)
     : QWidget{parent}
 {
-    this->config = "";
     this->color = color;
 
     layout.addWidget(&webEngine);
@@ -14,7 +13,7 @@ EbayMessagesFrame::EbayMessagesFrame(const QColor& color, QWidget* parent)
 }
 
 void EbayMessagesFrame::repopulate() {
-    if (config == "") {
+    if (messages == nullptr) {
         return;
     }
 
@@ -23,21 +22,21 @@ void EbayMessagesFrame::repopulate() {
                    "<meta name='viewport' content='width=device-width, initial-scale=1.0'>"
                    "<title>eBay Messages</title>";
 
-    html += "<body>";
-
     html += getCSS();
 
-    QXmlStreamReader xmlReader(config);
-    QMap<QString, QString> myMap;
-    processXml(xmlReader, myMap);
+    html += "<body>";
+
+    // Stale data is shown right away while the new copy is on its way, just say how old it is
+    html += StaleBanner::html(staleSinceMs);
 
-    QMap<QString, QString>::const_iterator it;
-    for (it = myMap.constBegin(); it != myMap.constEnd(); it++) {
-        if (it.value() == "false") {
-            if (it.key().contains("un mensaje acerca")) {
+    // Render straight from the message store, every unread message shows even if another one has the same subject
+    for (const EbayMessageHeader &header : messages->headers) {
+        if (!header.read) {
+            if (header.subject.contains("un mensaje acerca")) {
                 continue;
             }
-            QString subject = it.key();
+
+            QString subject = header.subject;
             subject.replace(" sent a message about", ":");
             qint64 index = subject.indexOf("#");
             if (index != -1) {
@@ -110,44 +109,19 @@ QString EbayMessagesFrame::getCSS() {
                "input[type='text'] { margin-right: 5px; font-size: 5vmin; width: 9em;}"
                "button { margin-right: 2.5px; font-weight: bold;  font-size: 5vmin;}"
                 ".goalsContainer { width: 100%; }"
+                + StaleBanner::css() +
                 "</style>";
 
 
     return styling;
 }
 
-void EbayMessagesFrame::processXml(QXmlStreamReader &xmlReader, QMap<QString, QString> &myMap) {
-
-    // We are now at the important part, the actual messages
-    QString elementSubject;
-    while (!xmlReader.atEnd() && !xmlReader.hasError()) {
-
-        QXmlStreamReader::TokenType token = xmlReader.readNext();
-        if (token == QXmlStreamReader::StartElement) {
-
-            QStringView elementName = xmlReader.name();
-            if (elementName == QString("Subject")) {
-                elementSubject = xmlReader.readElementText();
-            }
-            if (elementName == QString("Read")) {
-                myMap.insert(elementSubject, xmlReader.readElementText());
-            }
-        }
-    }
-
-    if (xmlReader.hasError()) {
-        qDebug() << "Error: " << xmlReader.errorString();
-    }
-    return;
-}
-
-void EbayMessagesFrame::setConfig(QByteArray &config) {
-    this->config = config;
+void EbayMessagesFrame::setMessages(EbayMessagesPtr messages) {
+    this->messages = messages;
 }
 
-void EbayMessagesFrame::setConfig(QJsonObject &config) {
-    QJsonDocument jsonDocument(config);
-    this->config = jsonDocument.toJson();
+void EbayMessagesFrame::setStaleSince(qint64 msecsSinceEpoch) {
+    staleSinceMs = msecsSinceEpoch;
 }
 
 void EbayMessagesFrame::darkMode() {
@@ -4,11 +4,9 @@
 #include <QWidget>
 #include <QWebEngineView>
 #include <QVBoxLayout>
-#include <QXmlStreamReader>
-#include <QMap>
 
-#include <QJsonObject>
-#include <QJsonDocument>
+#include "ebayresults.h"
+#include "stalebanner.h"
 
 class EbayMessagesFrame : public QWidget
 {
@@ -18,20 +16,21 @@ public:
 
     void repopulate();
 
-    void setConfig(QByteArray &config);
-
-    void setConfig(QJsonObject &config);
+    // The messages are parsed on the network thread, this only keeps a reference to the result
+    void setMessages(EbayMessagesPtr messages);
 
     void darkMode();
 
+    // When the data shown was fetched, if it is stale (0 when it is fresh)
+    void setStaleSince(qint64 msecsSinceEpoch);
+
 private:
     QWebEngineView webEngine;
-    QByteArray config;
+    EbayMessagesPtr messages;
     QColor color;
     QVBoxLayout layout;
     bool isDarkMode = false;
-
-    void processXml(QXmlStreamReader &xmlReader, QMap<QString, QString> &myMap);
+    qint64 staleSinceMs = 0;
 
     QString getCSS();
 signals:
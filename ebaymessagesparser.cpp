@@ -0,0 +1,96 @@
+#include "ebaymessagesparser.h"
+
+EbayMessagesParser::EbayMessagesParser()
+{
+}
+
+void EbayMessagesParser::addData(const QByteArray &chunk) {
+    if (failed) {
+        return;
+    }
+
+    reader.addData(chunk);
+    parseAvailable();
+}
+
+EbayMessageList EbayMessagesParser::finish() {
+    parseAvailable();
+
+    // Running out of bytes in the middle of the document means the reply was cut off. What was parsed is only part of the
+    // messages, so it counts as failed (the caller then keeps its sync point and asks for the same window again)
+    if (!failed && !documentEnded) {
+        qDebug() << "Error: messages response ended early";
+        failed = true;
+    }
+
+    return std::move(messages);
+}
+
+bool EbayMessagesParser::hasError() const {
+    return failed;
+}
+
+EbayMessageList EbayMessagesParser::parse(const QByteArray &xml) {
+    EbayMessagesParser parser;
+    parser.addData(xml);
+    return parser.finish();
+}
+
+void EbayMessagesParser::parseAvailable() {
+    // Only work with single tokens here (no readElementText) so running out of data in the middle of an element is fine,
+    // the reader just picks up where it stopped once more data is added
+    while (!reader.atEnd()) {
+        QXmlStreamReader::TokenType token = reader.readNext();
+
+        if (token == QXmlStreamReader::EndDocument) {
+            documentEnded = true;
+        } else if (token == QXmlStreamReader::StartElement) {
+            text.clear();
+            if (reader.name() == QString("Message")) {
+                inMessage = true;
+                current = EbayMessageHeader();
+            }
+        } else if (token == QXmlStreamReader::Characters) {
+            text += reader.text();
+        } else if (token == QXmlStreamReader::EndElement) {
+            endElement(reader.name());
+        }
+    }
+
+    if (reader.hasError() && reader.error() != QXmlStreamReader::PrematureEndOfDocumentError) {
+        qDebug() << "Error: " << reader.errorString();
+        failed = true;
+    }
+}
+
+void EbayMessagesParser::endElement(QStringView name) {
+    // A Trading API call that fails still comes back as a 200, only Ack says it didn't work
+    if (name == QString("Ack")) {
+        if (text == "Failure") {
+            qDebug() << "Error: GetMyMessages returned Ack Failure";
+            failed = true;
+        }
+        text.clear();
+        return;
+    }
+
+    if (!inMessage) {
+        return;
+    }
+
+    if (name == QString("Message")) {
+        messages.append(current);
+        inMessage = false;
+    } else if (name == QString("MessageID")) {
+        current.messageId = text;
+    } else if (name == QString("Subject")) {
+        current.subject = text;
+    } else if (name == QString("Sender")) {
+        current.sender = text;
+    } else if (name == QString("Read")) {
+        current.read = text == "true";
+    } else if (name == QString("ReceiveDate")) {
+        current.receiveDate = QDateTime::fromString(text, Qt::ISODate);
+    }
+    text.clear();
+}
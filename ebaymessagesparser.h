@@ -0,0 +1,46 @@
+#ifndef EBAYMESSAGESPARSER_H
+#define EBAYMESSAGESPARSER_H
+
+#include <QXmlStreamReader>
+#include <QByteArray>
+#include <QString>
+#include <QDebug>
+
+#include "ebayresults.h"
+
+/*
+ * Incremental parser for GetMyMessages (ReturnHeaders) responses.
+ * Feed it the reply as it arrives with addData() and it parses as far as the bytes allow, so by the time the reply
+ * finishes the message headers are already built. Nothing keeps the XML around afterwards.
+ */
+class EbayMessagesParser
+{
+public:
+    EbayMessagesParser();
+
+    void addData(const QByteArray &chunk);
+
+    // Call after the last chunk, returns every header that was parsed
+    EbayMessageList finish();
+
+    bool hasError() const;
+
+    // Parse a complete document in one go
+    static EbayMessageList parse(const QByteArray &xml);
+
+private:
+    QXmlStreamReader reader;
+    EbayMessageList messages;
+    EbayMessageHeader current;
+    QString text;
+    bool inMessage = false;
+    bool failed = false;
+    // Only set once the root element was closed, anything short of that was cut off
+    bool documentEnded = false;
+
+    void parseAvailable();
+
+    void endElement(QStringView name);
+};
+
+#endif // EBAYMESSAGESPARSER_H
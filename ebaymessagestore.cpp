@@ -0,0 +1,79 @@
+#include "ebaymessagestore.h"
+
+EbayMessageStore::EbayMessageStore()
+{
+}
+
+bool EbayMessageStore::needsFullSync(const QDateTime &now) const {
+    if (!syncedUntil.isValid() || !reconciledAt.isValid()) {
+        return true;
+    }
+    return reconciledAt.secsTo(now) >= reconcileSecs;
+}
+
+QDateTime EbayMessageStore::windowStart() const {
+    return syncedUntil.addSecs(-overlapSecs);
+}
+
+void EbayMessageStore::applyWindow(const EbayMessageList &headers, const QDateTime &endTime) {
+    for (const EbayMessageHeader &header : headers) {
+        insert(header);
+    }
+    syncedUntil = endTime;
+}
+
+void EbayMessageStore::applyFull(const EbayMessageList &headers, const QDateTime &endTime) {
+    this->headers.clear();
+    for (const EbayMessageHeader &header : headers) {
+        insert(header);
+    }
+    syncedUntil = endTime;
+    reconciledAt = endTime;
+}
+
+void EbayMessageStore::adopt(const EbayMessages &messages) {
+    // Anything older than what this store already has would only undo newer read flags
+    if (syncedUntil.isValid() && (!messages.syncedUntil.isValid() || messages.syncedUntil <= syncedUntil)) {
+        return;
+    }
+
+    headers.clear();
+    for (const EbayMessageHeader &header : messages.headers) {
+        insert(header);
+    }
+    syncedUntil = messages.syncedUntil;
+    reconciledAt = messages.reconciledAt;
+}
+
+bool EbayMessageStore::isEmpty() const {
+    return headers.isEmpty();
+}
+
+EbayMessagesPtr EbayMessageStore::snapshot() const {
+    EbayMessages messages;
+    messages.headers.reserve(headers.size());
+    for (const EbayMessageHeader &header : headers) {
+        messages.headers.append(header);
+    }
+
+    // Newest first, the same order eBay sends them in
+    std::sort(messages.headers.begin(), messages.headers.end(), [](const EbayMessageHeader &a, const EbayMessageHeader &b) {
+        return a.receiveDate > b.receiveDate;
+    });
+
+    messages.syncedUntil = syncedUntil;
+    messages.reconciledAt = reconciledAt;
+    return std::make_shared<const EbayMessages>(std::move(messages));
+}
+
+void EbayMessageStore::insert(const EbayMessageHeader &header) {
+    headers.insert(keyFor(header), header);
+}
+
+QString EbayMessageStore::keyFor(const EbayMessageHeader &header) {
+    // Headers from old cache files don't have an id, those are at least unique per subject and time
+    if (!header.messageId.isEmpty()) {
+        return header.messageId;
+    }
+    return header.subject + "@" + QString::number(header.receiveDate.toMSecsSinceEpoch());
+}
@@ -0,0 +1,58 @@
+#ifndef EBAYMESSAGESTORE_H
+#define EBAYMESSAGESTORE_H
+
+#include <QHash>
+#include <QString>
+#include <QDateTime>
+
+#include <algorithm>
+
+#include "ebayresults.h"
+
+/*
+ * Every message header the dashboard knows about, keyed by MessageID (so two messages with the same subject are still
+ * two messages). Polls only ask eBay for what arrived since the last sync, and every so often a full header call checks
+ * the read flag of everything again (reading a message doesn't change its ReceiveDate, so a windowed poll never sees it).
+ *
+ * Lives on the network thread, the GUI only ever sees the snapshots.
+ */
+class EbayMessageStore
+{
+public:
+    // How far back a windowed poll reaches past the last sync, in case eBay files a message a little late
+    static const int overlapSecs = 5 * 60;
+    // How often every message's read flag is checked again
+    static const int reconcileSecs = 15 * 60;
+
+    EbayMessageStore();
+
+    // True when the next poll should be a full call instead of a StartTime/EndTime window
+    bool needsFullSync(const QDateTime &now) const;
+
+    // Where the next windowed poll should start
+    QDateTime windowStart() const;
+
+    // Add or update the headers from a windowed poll that covered everything up to endTime
+    void applyWindow(const EbayMessageList &headers, const QDateTime &endTime);
+
+    // A full call returns every message eBay still has, so it replaces the store (this also drops deleted messages)
+    void applyFull(const EbayMessageList &headers, const QDateTime &endTime);
+
+    // Take over a snapshot from the cache or the leader if it is newer than what is here
+    void adopt(const EbayMessages &messages);
+
+    bool isEmpty() const;
+
+    EbayMessagesPtr snapshot() const;
+
+private:
+    QHash<QString, EbayMessageHeader> headers;
+    QDateTime syncedUntil;
+    QDateTime reconciledAt;
+
+    void insert(const EbayMessageHeader &header);
+
+    static QString keyFor(const EbayMessageHeader &header);
+};
+
+#endif // EBAYMESSAGESTORE_H
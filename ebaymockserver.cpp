@@ -0,0 +1,409 @@
+#include "ebaymockserver.h"
+
+EbayMockServer::EbayMockServer(const Options &options, QObject *parent)
+    : QObject{parent}
+{
+    this->options = options;
+
+    QObject::connect(&server, &QTcpServer::newConnection, this, &EbayMockServer::handleNewConnection);
+}
+
+bool EbayMockServer::start(quint16 port) {
+    if (!loadFixtures()) {
+        return false;
+    }
+
+    startedAt = QDateTime::currentDateTimeUtc();
+
+    if (!server.listen(QHostAddress::LocalHost, port)) {
+        qCritical() << "Failed to listen on port" << port << ":" << server.errorString();
+        return false;
+    }
+
+    qDebug() << "eBay mock server listening on http://127.0.0.1:" + QString::number(server.serverPort());
+    qDebug() << "Set \"api_base_url\" in the eBay section of ebay.config.json to that address to use it";
+    return true;
+}
+
+bool EbayMockServer::loadFixtures() {
+    QFile ordersFile(options.fixturesDir + "/orders.json");
+    if (!ordersFile.open(QIODevice::ReadOnly)) {
+        qCritical() << "Failed to open" << ordersFile.fileName();
+        return false;
+    }
+    orderTemplates = QJsonDocument::fromJson(ordersFile.readAll()).object().value("orders").toArray();
+    ordersFile.close();
+
+    QFile messagesFile(options.fixturesDir + "/messages.xml");
+    if (!messagesFile.open(QIODevice::ReadOnly)) {
+        qCritical() << "Failed to open" << messagesFile.fileName();
+        return false;
+    }
+    messageTemplates = EbayMessagesParser::parse(messagesFile.readAll());
+    messagesFile.close();
+
+    if (orderTemplates.isEmpty() || messageTemplates.isEmpty()) {
+        qCritical() << "The fixtures need at least one order and one message";
+        return false;
+    }
+
+    qDebug() << "Loaded" << orderTemplates.size() << "order and" << messageTemplates.size() << "message fixtures";
+    return true;
+}
+
+void EbayMockServer::handleNewConnection() {
+    while (server.hasPendingConnections()) {
+        QTcpSocket *socket = server.nextPendingConnection();
+
+        QObject::connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            readRequest(socket);
+        });
+        QObject::connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void EbayMockServer::readRequest(QTcpSocket *socket) {
+    QByteArray &buffer = buffers[socket];
+    buffer += socket->readAll();
+
+    // Wait for the rest if the whole request isn't here yet
+    Request request;
+    if (!parseRequest(buffer, request)) {
+        return;
+    }
+
+    QElapsedTimer handling;
+    handling.start();
+    Response response = route(request);
+    qint64 handlingMs = handling.elapsed();
+
+    // Hold the response back to act like a slow network. The socket is the context so nothing is sent to a closed connection
+    int delay = options.latencyMs;
+    if (options.latencyJitterMs > 0) {
+        delay += QRandomGenerator::global()->bounded(options.latencyJitterMs + 1);
+    }
+    QTimer::singleShot(delay, socket, [this, socket, request, response, handlingMs]() {
+        send(socket, request, response, handlingMs);
+    });
+}
+
+bool EbayMockServer::parseRequest(QByteArray &buffer, Request &request) {
+    qsizetype headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd == -1) {
+        return false;
+    }
+
+    QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() < 2) {
+        // Not HTTP, throw it away
+        buffer.clear();
+        return false;
+    }
+
+    request.method = requestLine[0];
+    request.url = QUrl::fromEncoded(requestLine[1]);
+
+    for (qsizetype i = 1; i < lines.size(); i++) {
+        qsizetype colon = lines[i].indexOf(':');
+        if (colon == -1) {
+            continue;
+        }
+        request.headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+    }
+
+    qsizetype contentLength = request.headers.value("content-length", "0").toLongLong();
+    qsizetype requestSize = headerEnd + 4 + contentLength;
+    if (buffer.size() < requestSize) {
+        return false;
+    }
+
+    request.body = buffer.mid(headerEnd + 4, contentLength);
+    buffer.remove(0, requestSize);
+    return true;
+}
+
+EbayMockServer::Response EbayMockServer::route(const Request &request) {
+    requestCount++;
+
+    Response fault = injectedFault();
+    if (fault.status != 0) {
+        return fault;
+    }
+
+    QString path = request.url.path();
+    if (request.method == "POST" && path == "/identity/v1/oauth2/token") {
+        return token(request);
+    }
+    if (request.method == "GET" && path == "/sell/fulfillment/v1/order") {
+        return orders(request);
+    }
+    if (request.method == "POST" && path == "/ws/api.dll") {
+        return messages(request);
+    }
+
+    Response response;
+    response.status = 404;
+    response.body = QJsonDocument(QJsonObject{{"errors", QJsonArray{QJsonObject{
+        {"errorId", 2002}, {"domain", "API_MOCK"}, {"category", "REQUEST"}, {"message", "Resource not found"}
+    }}}}).toJson(QJsonDocument::Compact);
+    return response;
+}
+
+EbayMockServer::Response EbayMockServer::token(const Request &request) {
+    Response response;
+
+    QUrlQuery form(QString::fromUtf8(request.body));
+    if (!request.headers.value("authorization").startsWith("Basic ")) {
+        response.status = 401;
+        response.body = R"({"error":"invalid_client","error_description":"client authentication failed"})";
+        return response;
+    }
+    if (form.queryItemValue("grant_type") != "refresh_token" || form.queryItemValue("refresh_token").isEmpty()) {
+        response.status = 400;
+        response.body = R"({"error":"invalid_grant","error_description":"the provided authorization refresh token is invalid or was issued to another client"})";
+        return response;
+    }
+
+    tokensIssued++;
+    response.body = QJsonDocument(QJsonObject{
+        {"access_token", "mock-access-token-" + QString::number(tokensIssued)},
+        {"expires_in", options.tokenLifetimeSecs},
+        {"token_type", "User Access Token"}
+    }).toJson(QJsonDocument::Compact);
+    return response;
+}
+
+EbayMockServer::Response EbayMockServer::orders(const Request &request) {
+    Response response;
+
+    if (!request.headers.value("authorization").startsWith("Bearer ")) {
+        response.status = 401;
+        response.body = QJsonDocument(QJsonObject{{"errors", QJsonArray{QJsonObject{
+            {"errorId", 1001}, {"domain", "OAuth"}, {"category", "REQUEST"}, {"message", "Invalid access token"}
+        }}}}).toJson(QJsonDocument::Compact);
+        return response;
+    }
+
+    QUrlQuery query(request.url);
+    int limit = query.hasQueryItem("limit") ? query.queryItemValue("limit").toInt() : 50;
+    limit = qBound(1, limit, options.maxPageSize);
+    int offset = qMax(0, query.queryItemValue("offset").toInt());
+
+    // The only filter the dashboard uses is creationdate:[from..to], either end can be left off
+    QDateTime from;
+    QDateTime to;
+    static const QRegularExpression creationDateFilter("creationdate:\\[(.*?)\\.\\.(.*?)\\]");
+    QRegularExpressionMatch match = creationDateFilter.match(query.queryItemValue("filter", QUrl::FullyDecoded));
+    if (match.hasMatch()) {
+        from = QDateTime::fromString(match.captured(1), Qt::ISODateWithMs);
+        to = QDateTime::fromString(match.captured(2), Qt::ISODateWithMs);
+    }
+
+    QJsonArray matching;
+    for (const QJsonValue &order : buildOrders()) {
+        QDateTime created = QDateTime::fromString(order.toObject().value("creationDate").toString(), Qt::ISODateWithMs);
+        if ((from.isValid() && created < from) || (to.isValid() && created > to)) {
+            continue;
+        }
+        matching.append(order);
+    }
+
+    QJsonArray page;
+    for (int i = offset; i < matching.size() && i < offset + limit; i++) {
+        page.append(matching[i]);
+    }
+
+    QJsonObject body{
+        {"href", request.url.toString()},
+        {"total", matching.size()},
+        {"limit", limit},
+        {"offset", offset},
+        {"orders", page}
+    };
+
+    // Same as eBay, the next page is a ready to use link
+    if (offset + limit < matching.size()) {
+        QUrl next = request.url;
+        QUrlQuery nextQuery = query;
+        nextQuery.removeAllQueryItems("offset");
+        nextQuery.addQueryItem("offset", QString::number(offset + limit));
+        next.setQuery(nextQuery);
+        body["next"] = next.toString();
+    }
+
+    response.body = QJsonDocument(body).toJson(QJsonDocument::Compact);
+    return response;
+}
+
+EbayMockServer::Response EbayMockServer::messages(const Request &request) {
+    Response response;
+    response.contentType = "text/xml";
+
+    QByteArray failure;
+    if (request.headers.value("x-ebay-api-iaf-token").isEmpty()) {
+        failure = "931";
+    } else if (request.headers.value("x-ebay-api-call-name") != "GetMyMessages") {
+        failure = "2";
+    }
+
+    // StartTime and EndTime are optional, without them every message comes back
+    QDateTime startTime;
+    QDateTime endTime;
+    static const QRegularExpression startTimeTag("<StartTime>(.*?)</StartTime>");
+    static const QRegularExpression endTimeTag("<EndTime>(.*?)</EndTime>");
+    QString body = QString::fromUtf8(request.body);
+    QRegularExpressionMatch startMatch = startTimeTag.match(body);
+    if (startMatch.hasMatch()) {
+        startTime = QDateTime::fromString(startMatch.captured(1), Qt::ISODateWithMs);
+    }
+    QRegularExpressionMatch endMatch = endTimeTag.match(body);
+    if (endMatch.hasMatch()) {
+        endTime = QDateTime::fromString(endMatch.captured(1), Qt::ISODateWithMs);
+    }
+
+    // Trading API calls fail with a 200 and Ack set to Failure
+    QXmlStreamWriter writer(&response.body);
+    writer.writeStartDocument();
+    writer.writeStartElement("GetMyMessagesResponse");
+    writer.writeDefaultNamespace("urn:ebay:apis:eBLBaseComponents");
+    writer.writeTextElement("Timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+
+    if (!failure.isEmpty()) {
+        writer.writeTextElement("Ack", "Failure");
+        writer.writeStartElement("Errors");
+        writer.writeTextElement("ShortMessage", failure == "931" ? "Auth token is invalid." : "Unsupported API call.");
+        writer.writeTextElement("ErrorCode", QString::fromUtf8(failure));
+        writer.writeTextElement("SeverityCode", "Error");
+        writer.writeEndElement();
+    } else {
+        writer.writeTextElement("Ack", "Success");
+        writer.writeTextElement("Version", "967");
+        writer.writeTextElement("Build", "mock");
+        writer.writeStartElement("Messages");
+        for (const EbayMessageHeader &header : buildMessages()) {
+            if ((startTime.isValid() && header.receiveDate < startTime) || (endTime.isValid() && header.receiveDate > endTime)) {
+                continue;
+            }
+
+            writer.writeStartElement("Message");
+            writer.writeTextElement("Sender", header.sender);
+            writer.writeTextElement("MessageID", header.messageId);
+            writer.writeTextElement("Subject", header.subject);
+            writer.writeTextElement("Read", header.read ? "true" : "false");
+            writer.writeTextElement("ReceiveDate", header.receiveDate.toString(Qt::ISODateWithMs));
+            writer.writeEndElement();
+        }
+        writer.writeEndElement();
+    }
+
+    writer.writeEndElement();
+    writer.writeEndDocument();
+    return response;
+}
+
+EbayMockServer::Response EbayMockServer::injectedFault() {
+    Response response;
+    response.status = 0;
+
+    double roll = QRandomGenerator::global()->generateDouble();
+    if (roll < options.throttleRate) {
+        response.status = 429;
+        response.headers.insert("Retry-After", "2");
+        response.body = QJsonDocument(QJsonObject{{"errors", QJsonArray{QJsonObject{
+            {"errorId", 2001}, {"domain", "ACCESS"}, {"category", "REQUEST"},
+            {"message", "Too many requests. The request limit has been reached for the resource."}
+        }}}}).toJson(QJsonDocument::Compact);
+    } else if (roll < options.throttleRate + options.serverErrorRate) {
+        response.status = QRandomGenerator::global()->bounded(2) == 0 ? 500 : 503;
+        response.body = QJsonDocument(QJsonObject{{"errors", QJsonArray{QJsonObject{
+            {"errorId", 2003}, {"domain", "ACCESS"}, {"category", "APPLICATION"},
+            {"message", "There was a problem with an eBay internal system or process."}
+        }}}}).toJson(QJsonDocument::Compact);
+    }
+    return response;
+}
+
+void EbayMockServer::send(QTcpSocket *socket, const Request &request, const Response &response, qint64 handlingMs) {
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(response.status) + " " + statusText(response.status) + "\r\n";
+    head += "Content-Type: " + response.contentType + "\r\n";
+    head += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+    head += "Connection: close\r\n";
+    for (auto it = response.headers.constBegin(); it != response.headers.constEnd(); it++) {
+        head += it.key() + ": " + it.value() + "\r\n";
+    }
+    head += "\r\n";
+
+    socket->write(head);
+    socket->write(response.body);
+    socket->disconnectFromHost();
+
+    qDebug().noquote() << "#" + QString::number(requestCount) << request.method << request.url.path() << response.status
+                       << response.body.size() << "bytes, built in" << handlingMs << "ms";
+}
+
+QJsonArray EbayMockServer::buildOrders() const {
+    int count = options.orderCount > 0 ? options.orderCount : orderTemplates.size();
+
+    // Spread the orders evenly over the last 45 days so the week and month counts have something to count
+    qint64 spacingSecs = qMax<qint64>(60, 45 * 24 * 60 * 60 / count);
+
+    QJsonArray orders;
+    for (int i = 0; i < count; i++) {
+        QJsonObject order = orderTemplates[i % orderTemplates.size()].toObject();
+        QDateTime created = startedAt.addSecs(-i * spacingSecs);
+
+        order["orderId"] = QString("MOCK-%1").arg(i, 6, 10, QChar('0'));
+        order["creationDate"] = created.toString(Qt::ISODateWithMs);
+        order["lastModifiedDate"] = created.toString(Qt::ISODateWithMs);
+
+        QJsonArray lineItems = order.value("lineItems").toArray();
+        for (qsizetype j = 0; j < lineItems.size(); j++) {
+            QJsonObject lineItem = lineItems[j].toObject();
+            lineItem["lineItemId"] = QString("MOCK-%1-%2").arg(i).arg(j);
+
+            QJsonObject instructions = lineItem.value("lineItemFulfillmentInstructions").toObject();
+            instructions["shipByDate"] = created.addDays(3).toString(Qt::ISODateWithMs);
+            lineItem["lineItemFulfillmentInstructions"] = instructions;
+            lineItems[j] = lineItem;
+        }
+        order["lineItems"] = lineItems;
+
+        orders.append(order);
+    }
+    return orders;
+}
+
+EbayMessageList EbayMockServer::buildMessages() const {
+    int count = options.messageCount > 0 ? options.messageCount : messageTemplates.size();
+    qint64 spacingSecs = qMax(1, options.messageIntervalSecs);
+
+    // The first count messages were already there at startup, after that a new one comes in every messageIntervalSecs
+    // (that is what the dashboard's StartTime windows should pick up)
+    qint64 arrived = startedAt.secsTo(QDateTime::currentDateTimeUtc()) / spacingSecs;
+
+    EbayMessageList messages;
+    for (qint64 i = count + arrived - 1; i >= 0; i--) {
+        EbayMessageHeader header = messageTemplates[i % messageTemplates.size()];
+        header.messageId = QString("MOCK-MSG-%1").arg(i, 8, 10, QChar('0'));
+        header.receiveDate = startedAt.addSecs((i - count + 1) * spacingSecs);
+        messages.append(header);
+    }
+    return messages;
+}
+
+QByteArray EbayMockServer::statusText(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef EBAYMOCKSERVER_H
+#define EBAYMOCKSERVER_H
+
+#include <QObject>
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+#include <QUrl>
+#include <QUrlQuery>
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+#include <QXmlStreamWriter>
+#include <QRegularExpression>
+#include <QRandomGenerator>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QFile>
+#include <QTimer>
+#include <QDebug>
+
+#include "ebayresults.h"
+#include "ebaymessagesparser.h"
+
+/*
+ * A stand-in for the parts of api.ebay.com the dashboard uses, so the eBay page can be benchmarked and tested without
+ * touching the real API (or the rate limits). Point the dashboard at it with "api_base_url" in ebay.config.json.
+ *
+ * It answers the OAuth token call, fulfillment GetOrders and Trading GetMyMessages with responses built from the
+ * recorded fixtures in mockfixtures/. The fixtures are used as templates, so the number of orders/messages (the payload
+ * size) can be turned up as far as needed. Latency and 429/5xx errors can be injected to see how the dashboard copes.
+ *
+ * This is a very small HTTP/1.1 server, every response closes its connection.
+ */
+class EbayMockServer : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options
+    {
+        QString fixturesDir = "mockfixtures";
+        // Added to every response, plus a random amount up to latencyJitterMs
+        int latencyMs = 0;
+        int latencyJitterMs = 0;
+        // How many orders/messages exist, the fixtures are repeated to get there (0 means just the fixtures)
+        int orderCount = 0;
+        int messageCount = 0;
+        // How often a new message comes in while the server runs
+        int messageIntervalSecs = 600;
+        // The most orders GetOrders hands out per page, eBay's own limit is 200
+        int maxPageSize = 200;
+        // Chance (0 to 1) that a request is answered with 429 Too Many Requests or a 5xx instead
+        double throttleRate = 0;
+        double serverErrorRate = 0;
+        // expires_in of the tokens handed out
+        int tokenLifetimeSecs = 7200;
+    };
+
+    explicit EbayMockServer(const Options &options, QObject *parent = nullptr);
+
+    // Loads the fixtures and starts listening on localhost
+    bool start(quint16 port);
+
+private:
+    struct Request
+    {
+        QByteArray method;
+        QUrl url;
+        QHash<QByteArray, QByteArray> headers;
+        QByteArray body;
+    };
+
+    struct Response
+    {
+        int status = 200;
+        QByteArray contentType = "application/json";
+        QByteArray body;
+        QHash<QByteArray, QByteArray> headers;
+    };
+
+    Options options;
+    QTcpServer server;
+    QHash<QTcpSocket*, QByteArray> buffers;
+    QJsonArray orderTemplates;
+    EbayMessageList messageTemplates;
+    // Fixed at startup so the same order/message keeps the same dates for the whole run
+    QDateTime startedAt;
+    qint64 tokensIssued = 0;
+    qint64 requestCount = 0;
+
+    bool loadFixtures();
+
+    void handleNewConnection();
+
+    void readRequest(QTcpSocket *socket);
+
+    bool parseRequest(QByteArray &buffer, Request &request);
+
+    Response route(const Request &request);
+
+    Response token(const Request &request);
+
+    Response orders(const Request &request);
+
+    Response messages(const Request &request);
+
+    Response injectedFault();
+
+    void send(QTcpSocket *socket, const Request &request, const Response &response, qint64 handlingMs);
+
+    QJsonArray buildOrders() const;
+
+    EbayMessageList buildMessages() const;
+
+    static QByteArray statusText(int status);
+};
+
+#endif // EBAYMOCKSERVER_H
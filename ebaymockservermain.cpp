@@ -0,0 +1,55 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+
+#include "ebaymockserver.h"
+
+/*
+ * Runs the offline eBay API stand-in, for example:
+ *   ebayMockServer --port 8089 --latency 300 --jitter 200 --orders 2000 --throttle-rate 0.05
+ * then add "api_base_url": "http://127.0.0.1:8089" to the eBay section of ebay.config.json
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ebayMockServer");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Offline stand-in for the eBay API endpoints the Goals Dashboard uses");
+    parser.addHelpOption();
+
+    QCommandLineOption portOption("port", "Port to listen on (localhost only).", "port", "8089");
+    QCommandLineOption fixturesOption("fixtures", "Directory with orders.json and messages.xml.", "dir", "mockfixtures");
+    QCommandLineOption latencyOption("latency", "Milliseconds added to every response.", "ms", "0");
+    QCommandLineOption jitterOption("jitter", "Up to this many more random milliseconds per response.", "ms", "0");
+    QCommandLineOption ordersOption("orders", "Number of orders to serve (0 = just the fixtures).", "count", "0");
+    QCommandLineOption messagesOption("messages", "Number of messages at startup (0 = just the fixtures).", "count", "0");
+    QCommandLineOption messageIntervalOption("message-interval", "Seconds between new messages coming in.", "secs", "600");
+    QCommandLineOption pageSizeOption("page-size", "Most orders returned per GetOrders page.", "count", "200");
+    QCommandLineOption throttleOption("throttle-rate", "Chance (0-1) of answering 429 Too Many Requests.", "rate", "0");
+    QCommandLineOption serverErrorOption("error-rate", "Chance (0-1) of answering 500/503.", "rate", "0");
+    QCommandLineOption tokenLifetimeOption("token-lifetime", "expires_in of the access tokens handed out, in seconds.", "secs", "7200");
+
+    parser.addOptions({portOption, fixturesOption, latencyOption, jitterOption, ordersOption, messagesOption,
+                       messageIntervalOption, pageSizeOption, throttleOption, serverErrorOption, tokenLifetimeOption});
+    parser.process(app);
+
+    EbayMockServer::Options options;
+    options.fixturesDir = parser.value(fixturesOption);
+    options.latencyMs = parser.value(latencyOption).toInt();
+    options.latencyJitterMs = parser.value(jitterOption).toInt();
+    options.orderCount = parser.value(ordersOption).toInt();
+    options.messageCount = parser.value(messagesOption).toInt();
+    options.messageIntervalSecs = parser.value(messageIntervalOption).toInt();
+    options.maxPageSize = parser.value(pageSizeOption).toInt();
+    options.throttleRate = parser.value(throttleOption).toDouble();
+    options.serverErrorRate = parser.value(serverErrorOption).toDouble();
+    options.tokenLifetimeSecs = parser.value(tokenLifetimeOption).toInt();
+
+    EbayMockServer server(options);
+    if (!server.start(parser.value(portOption).toUShort())) {
+        return 1;
+    }
+
+    return app.exec();
+}
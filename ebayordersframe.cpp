@@ -3,7 +3,6 @@
 EbayOrdersFrame::EbayOrdersFrame(const QColor& color, QWidget* parent)
     : QWidget{parent}, webEngine{this}, layout{this}
 {
-    this->ordersJson = nullptr;
     this->color = color;
 
     layout.addWidget(&webEngine);
@@ -14,7 +13,7 @@ EbayOrdersFrame::EbayOrdersFrame(const QColor& color, QWidget* parent)
 }
 
 void EbayOrdersFrame::repopulate() {
-    if (ordersJson == nullptr) {
+    if (orders == nullptr) {
         return;
     }
 
@@ -27,58 +26,23 @@ void EbayOrdersFrame::repopulate() {
 
     html += "<body>";
 
-    if (!ordersJson->isEmpty()) {
-        qint64 numOrders = 0;
-        if (!ordersJson->value("orders").isArray()) {
-            html += "<p>Failed to open json</p></body></html>";
-            webEngine.setHtml(html);
-        }
-        QJsonArray ordersArray = ordersJson->value("orders").toArray();
-        for (auto&& order : ordersArray) {
-            if (!order.isObject()) {
-                continue;
-            }
-            QJsonObject orderObj = order.toObject();
-            if (!orderObj["lineItems"].isArray()) {
-                continue;
-            }
-
-            QJsonObject cancelStatusObj = orderObj.value("cancelStatus").toObject();
-            if (cancelStatusObj.value("cancelState").toString() == "CANCELED") {
-                continue;
-            }
-
-            QJsonArray lineItems = orderObj["lineItems"].toArray();
-            for (auto&& lineItem : lineItems) {
-                QJsonObject lineItemObj = lineItem.toObject();
-                QString fulfillmentStatus = lineItemObj.value("lineItemFulfillmentStatus").toString();
-
-                if (fulfillmentStatus != "NOT_STARTED") {
-                    continue;
-                }
-
-
-
-                numOrders++;
-
-                QString itemTitle = lineItemObj.value("title").toString();
-                QString shipByDate = "N/A";
-                if (lineItemObj.value("lineItemFulfillmentInstructions").isObject()) {
-                    QJsonObject fulfillmentInstructions = lineItemObj.value("lineItemFulfillmentInstructions").toObject();
-                    shipByDate = fulfillmentInstructions.value("shipByDate").toString();
-                    if (shipByDate != "") {
-                        QDateTime dateTime = QDateTime::fromString(shipByDate, Qt::ISODate);
-                        shipByDate = dateTime.toString();
-                    } else {
-                        shipByDate = "N/A";
-                    }
-                }
-                html += "<h4>Item: " + itemTitle + "</h4>";
-                html += "<h5> Ship by: " + shipByDate + "</h5>";
+    // Stale data is shown right away while the new copy is on its way, just say how old it is
+    html += StaleBanner::html(staleSinceMs);
 
+    if (!orders->valid) {
+        html += "<p>Failed to open json</p>";
+    } else {
+        // Everything was parsed when the response came in, this only picks the unshipped items out
+        QVector<int> awaiting = orders->awaitingShipment();
+        for (int item : awaiting) {
+            QString shipByDate = "N/A";
+            if (orders->itemShipByMs[item] != 0) {
+                shipByDate = QDateTime::fromMSecsSinceEpoch(orders->itemShipByMs[item]).toString();
             }
+            html += "<h4>Item: " + orders->itemTitle[item] + "</h4>";
+            html += "<h5> Ship by: " + shipByDate + "</h5>";
         }
-        html += "<h3>Total Orders: " + QString::number(numOrders) + "<h3>";
+        html += "<h3>Total Orders: " + QString::number(awaiting.size()) + "<h3>";
     }
 
     html += "</body></html>";
@@ -86,8 +50,12 @@ void EbayOrdersFrame::repopulate() {
     webEngine.setHtml(html);
 }
 
-void EbayOrdersFrame::setOrdersJson(QJsonObject* ordersJson) {
-    this->ordersJson = ordersJson;
+void EbayOrdersFrame::setOrders(EbayOrderStorePtr orders) {
+    this->orders = orders;
+}
+
+void EbayOrdersFrame::setStaleSince(qint64 msecsSinceEpoch) {
+    staleSinceMs = msecsSinceEpoch;
 }
 
 void EbayOrdersFrame::darkMode() {
@@ -151,6 +119,7 @@ QString EbayOrdersFrame::getCSS() {
                "input[type='text'] { margin-right: 5px; font-size: 5vmin; width: 9em;}"
                "button { margin-right: 2.5px; font-weight: bold;  font-size: 5vmin;}"
                ".goalsContainer { width: 100%; }"
+               + StaleBanner::css() +
                "</style>";
 
 
@@ -7,7 +7,10 @@
 #include <QJsonObject>
 #include <QVBoxLayout>
 #include <QJsonArray>
+#include <QDateTime>
 
+#include "ebayorderstore.h"
+#include "stalebanner.h"
 
 class EbayOrdersFrame : public QWidget
 {
@@ -15,17 +18,21 @@ class EbayOrdersFrame : public QWidget
 public:
     explicit EbayOrdersFrame(const QColor& color, QWidget* parent = nullptr);
 
-    void setOrdersJson(QJsonObject* ordersJson);
+    void setOrders(EbayOrderStorePtr orders);
     void darkMode();
 
+    // When the data shown was fetched, if it is stale (0 when it is fresh)
+    void setStaleSince(qint64 msecsSinceEpoch);
+
     void repopulate();
 private:
 
     QWebEngineView webEngine;
     QColor color;
-    QJsonObject* ordersJson;
+    EbayOrderStorePtr orders;
     QVBoxLayout layout;
     bool isDarkMode = false;
+    qint64 staleSinceMs = 0;
 
     QString getCSS();
 
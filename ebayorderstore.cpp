@@ -0,0 +1,95 @@
+#include "ebayorderstore.h"
+
+EbayOrderStore EbayOrderStore::fromJson(const QJsonObject &ordersJson) {
+    EbayOrderStore store;
+    if (!ordersJson.value("orders").isArray()) {
+        return store;
+    }
+    store.valid = true;
+
+    QJsonArray ordersArray = ordersJson.value("orders").toArray();
+    store.orderId.reserve(ordersArray.size());
+    store.orderCreatedMs.reserve(ordersArray.size());
+    store.orderCanceled.reserve(ordersArray.size());
+    store.orderUnits.reserve(ordersArray.size());
+    store.orderGrossCents.reserve(ordersArray.size());
+    store.orderTaxCents.reserve(ordersArray.size());
+    store.orderFeeCents.reserve(ordersArray.size());
+
+    for (auto&& order : ordersArray) {
+        if (!order.isObject()) {
+            continue;
+        }
+        QJsonObject orderObj = order.toObject();
+
+        int orderIndex = store.orderCreatedMs.size();
+        store.orderId.append(orderObj.value("orderId").toString());
+        store.orderCreatedMs.append(parseDate(orderObj.value("creationDate").toString()));
+        store.orderCanceled.append(orderObj.value("cancelStatus").toObject().value("cancelState").toString() == "CANCELED");
+        store.orderGrossCents.append(parseCents(orderObj.value("pricingSummary").toObject().value("total")));
+        store.orderFeeCents.append(parseCents(orderObj.value("totalMarketplaceFee")));
+
+        // Units and tax are per line item, the tax comes from the TAX_BREAKDOWN field group
+        int units = 0;
+        qint64 taxCents = 0;
+        QJsonArray lineItems = orderObj.value("lineItems").toArray();
+        for (auto&& lineItem : lineItems) {
+            QJsonObject lineItemObj = lineItem.toObject();
+
+            units += lineItemObj.value("quantity").toInt(1);
+            for (const char *taxField : {"taxes", "ebayCollectAndRemitTaxes"}) {
+                for (auto&& tax : lineItemObj.value(taxField).toArray()) {
+                    taxCents += parseCents(tax.toObject().value("amount"));
+                }
+            }
+
+            store.itemOrder.append(orderIndex);
+            store.itemFulfillment.append(fulfillmentFrom(lineItemObj.value("lineItemFulfillmentStatus").toString()));
+            store.itemShipByMs.append(parseDate(lineItemObj.value("lineItemFulfillmentInstructions").toObject().value("shipByDate").toString()));
+            store.itemTitle.append(lineItemObj.value("title").toString());
+        }
+        store.orderUnits.append(units);
+        store.orderTaxCents.append(taxCents);
+    }
+    return store;
+}
+
+int EbayOrderStore::orderCount() const {
+    return orderCreatedMs.size();
+}
+
+QVector<int> EbayOrderStore::awaitingShipment() const {
+    QVector<int> items;
+    for (int i = 0; i < itemOrder.size(); i++) {
+        if (itemFulfillment[i] == Fulfillment::NotStarted && !orderCanceled[itemOrder[i]]) {
+            items.append(i);
+        }
+    }
+    return items;
+}
+
+EbayOrderStore::Fulfillment EbayOrderStore::fulfillmentFrom(const QString &status) {
+    if (status == "NOT_STARTED") {
+        return Fulfillment::NotStarted;
+    }
+    if (status == "IN_PROGRESS") {
+        return Fulfillment::InProgress;
+    }
+    if (status == "FULFILLED") {
+        return Fulfillment::Fulfilled;
+    }
+    return Fulfillment::Unknown;
+}
+
+qint64 EbayOrderStore::parseDate(const QString &date) {
+    if (date.isEmpty()) {
+        return 0;
+    }
+    QDateTime dateTime = QDateTime::fromString(date, Qt::ISODateWithMs);
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : 0;
+}
+
+qint64 EbayOrderStore::parseCents(const QJsonValue &amount) {
+    // eBay sends the value as a string
+    return qRound64(amount.toObject().value("value").toString().toDouble() * 100);
+}
@@ -0,0 +1,69 @@
+#ifndef EBAYORDERSTORE_H
+#define EBAYORDERSTORE_H
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QString>
+#include <QVector>
+#include <QDateTime>
+
+#include <memory>
+
+/*
+ * The orders from a GetOrders response, parsed once into columns so the panels never walk the JSON or parse dates again.
+ *
+ * Orders and line items each get their own set of columns (a struct of arrays): the order columns are indexed by order,
+ * the item columns by line item, and itemOrder says which order a line item belongs to. Dates are epoch milliseconds
+ * (0 when eBay didn't send one).
+ *
+ * Built once per response and handed around as an immutable shared snapshot, so a panel keeps whatever it was given
+ * alive for as long as it needs it.
+ */
+class EbayOrderStore
+{
+public:
+    enum class Fulfillment
+    {
+        NotStarted,
+        InProgress,
+        Fulfilled,
+        Unknown
+    };
+
+    // False if the response had no orders array at all (as opposed to an empty one)
+    bool valid = false;
+
+    // Per order, money is in cents of the order's currency
+    QVector<QString> orderId;
+    QVector<qint64> orderCreatedMs;
+    QVector<bool> orderCanceled;
+    QVector<int> orderUnits;
+    QVector<qint64> orderGrossCents;
+    QVector<qint64> orderTaxCents;
+    QVector<qint64> orderFeeCents;
+
+    // Per line item
+    QVector<int> itemOrder;
+    QVector<Fulfillment> itemFulfillment;
+    QVector<qint64> itemShipByMs;
+    QVector<QString> itemTitle;
+
+    static EbayOrderStore fromJson(const QJsonObject &ordersJson);
+
+    int orderCount() const;
+
+    // Line items of orders that weren't canceled and haven't been shipped yet, in the order eBay sent them
+    QVector<int> awaitingShipment() const;
+
+private:
+    static Fulfillment fulfillmentFrom(const QString &status);
+
+    static qint64 parseDate(const QString &date);
+
+    // An eBay Amount object ({"value": "12.34", "currency": "USD"}) in cents
+    static qint64 parseCents(const QJsonValue &amount);
+};
+
+using EbayOrderStorePtr = std::shared_ptr<const EbayOrderStore>;
+
+#endif // EBAYORDERSTORE_H
@@ -0,0 +1,203 @@
+#include "ebayrequestmanager.h"
+
+void EbayRequestManager::ReplyDeleter::operator()(QNetworkReply *reply) const {
+    if (reply == nullptr) {
+        return;
+    }
+
+    // Disconnect first so aborting doesn't call back into the manager while it is cleaning up
+    reply->disconnect();
+    if (reply->isRunning()) {
+        reply->abort();
+    }
+    reply->deleteLater();
+}
+
+QString ebayApiBaseUrl(const QJsonObject &ebayConfigJson) {
+    QString baseUrl = ebayConfigJson.value("eBay").toObject().value("api_base_url").toString();
+    if (baseUrl.isEmpty()) {
+        return "https://api.ebay.com";
+    }
+
+    while (baseUrl.endsWith('/')) {
+        baseUrl.chop(1);
+    }
+    return baseUrl;
+}
+
+EbayRequestManager::EbayRequestManager(QObject *parent)
+    : QObject{parent}
+{
+    manager = new QNetworkAccessManager(this);
+}
+
+EbayRequestManager::~EbayRequestManager() {
+    // Release every reply that is still running (the deleter aborts them) before the network manager goes away
+    pending.clear();
+}
+
+void EbayRequestManager::get(const QString &key, const QNetworkRequest &request, Callback callback) {
+    if (subscribe(key, callback)) {
+        return;
+    }
+
+    QNetworkRequest prepared = prepare(key, request);
+    track(key, prepared, manager->get(prepared), std::move(callback));
+}
+
+void EbayRequestManager::post(const QString &key, const QNetworkRequest &request, const QByteArray &data, Callback callback, ChunkHandler onChunk) {
+    if (subscribe(key, callback)) {
+        return;
+    }
+
+    QNetworkRequest prepared = prepare(key, request);
+    track(key, prepared, manager->post(prepared, data), std::move(callback), std::move(onChunk));
+}
+
+int EbayRequestManager::inFlight() const {
+    return static_cast<int>(pending.size());
+}
+
+bool EbayRequestManager::isInFlight(const QString &key) const {
+    return pending.find(key) != pending.end();
+}
+
+qint64 EbayRequestManager::coalescedCount() const {
+    return coalesced;
+}
+
+void EbayRequestManager::setTimeout(const QString &endpoint, int msecs) {
+    timeouts[endpoint] = msecs;
+}
+
+void EbayRequestManager::cancel(const QString &key) {
+    auto it = pending.find(key);
+    if (it == pending.end()) {
+        return;
+    }
+
+    qDebug() << "cancelling request for" << key;
+    it->second.canceled = true;
+    // Aborting finishes the reply right away, which runs finish() and takes the request out of the map
+    it->second.reply->abort();
+}
+
+const std::map<QString, LatencyHistogram> &EbayRequestManager::latencies() const {
+    return histograms;
+}
+
+QString EbayRequestManager::endpointFor(const QNetworkRequest &request) {
+    // Every Trading API call goes to the same url, the call name is what tells them apart
+    QByteArray callName = request.rawHeader("X-EBAY-API-CALL-NAME");
+    if (!callName.isEmpty()) {
+        return QString::fromUtf8(callName);
+    }
+    return request.url().path();
+}
+
+QNetworkRequest EbayRequestManager::prepare(const QString &key, const QNetworkRequest &request) {
+    QString endpoint = endpointFor(request);
+
+    // Only the newest request to an endpoint matters, so an older one still running (a different key) is dropped
+    QList<QString> superseded;
+    for (const auto &[pendingKey, pendingRequest] : pending) {
+        if (pendingKey != key && pendingRequest.endpoint == endpoint) {
+            superseded.append(pendingKey);
+        }
+    }
+    for (const QString &oldKey : superseded) {
+        cancel(oldKey);
+    }
+
+    // Without a transfer timeout a connection that stops sending would keep the request (and everyone waiting on it) forever
+    QNetworkRequest prepared = request;
+    if (prepared.transferTimeout() == 0) {
+        auto it = timeouts.find(endpoint);
+        prepared.setTransferTimeout(it != timeouts.end() ? it->second : defaultTimeoutMs);
+    }
+    return prepared;
+}
+
+bool EbayRequestManager::subscribe(const QString &key, Callback &callback) {
+    auto it = pending.find(key);
+    if (it == pending.end()) {
+        return false;
+    }
+
+    // The same request is already on the wire so just wait for that one. Only the callback joins it, the body chunks keep
+    // going to the first caller's chunk handler, so a streaming caller has to check isInFlight() itself
+    it->second.subscribers.append(std::move(callback));
+    coalesced++;
+    qDebug() << "coalesced request for" << key;
+    return true;
+}
+
+void EbayRequestManager::track(const QString &key, const QNetworkRequest &networkRequest, QNetworkReply *reply, Callback callback, ChunkHandler onChunk) {
+    PendingRequest &request = pending[key];
+    request.reply.reset(reply);
+    request.subscribers.append(std::move(callback));
+    request.onChunk = std::move(onChunk);
+    request.endpoint = endpointFor(networkRequest);
+    request.timeoutMs = networkRequest.transferTimeout();
+    request.started.start();
+
+    if (request.onChunk) {
+        // Hand the body over as it arrives instead of buffering all of it in the reply
+        QObject::connect(reply, &QNetworkReply::readyRead, this, [this, key]() {
+            auto it = pending.find(key);
+            if (it != pending.end()) {
+                it->second.onChunk(it->second.reply->readAll());
+            }
+        });
+    }
+
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, key]() {
+        finish(key);
+    });
+
+    emit inFlightChanged(inFlight());
+}
+
+void EbayRequestManager::finish(const QString &key) {
+    auto it = pending.find(key);
+    if (it == pending.end()) {
+        return;
+    }
+
+    // Take the request out of the map before calling anyone so a subscriber can start a new request for the same key
+    PendingRequest request = std::move(it->second);
+    pending.erase(it);
+
+    EbayResponse response;
+    response.error = request.reply->error();
+    response.httpStatus = request.reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    response.canceled = request.canceled;
+    if (response.error != QNetworkReply::NoError) {
+        response.errorString = request.reply->errorString();
+    }
+    // A transfer timeout also shows up as OperationCanceledError, so say what actually happened
+    if (response.error == QNetworkReply::OperationCanceledError && !request.canceled) {
+        response.errorString = "Timed out after " + QString::number(request.timeoutMs) + " ms";
+    }
+
+    // Cancelled requests didn't run their course so they would only skew the numbers, timeouts are the slow tail so they count
+    if (!request.canceled) {
+        histograms[request.endpoint].record(request.started.nsecsElapsed() / 1000);
+    }
+    if (request.onChunk) {
+        QByteArray rest = request.reply->readAll();
+        if (!rest.isEmpty()) {
+            request.onChunk(rest);
+        }
+    } else {
+        response.body = request.reply->readAll();
+    }
+
+    for (const Callback &callback : request.subscribers) {
+        callback(response);
+    }
+
+    // Report the gauge after the subscribers ran so follow up requests they started are already counted
+    emit inFlightChanged(inFlight());
+    // request.reply goes out of scope here and the deleter schedules the reply for deletion
+}
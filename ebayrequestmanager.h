@@ -0,0 +1,127 @@
+#ifndef EBAYREQUESTMANAGER_H
+#define EBAYREQUESTMANAGER_H
+
+#include <QObject>
+
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+
+#include <QJsonObject>
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include <functional>
+#include <memory>
+#include <map>
+
+#include "latencyhistogram.h"
+
+// The result of a finished request. The body is read out of the reply exactly once and handed to every subscriber
+struct EbayResponse
+{
+    QNetworkReply::NetworkError error = QNetworkReply::NoError;
+    QString errorString;
+    int httpStatus = 0;
+    QByteArray body;
+    // The request was cancelled on purpose (superseded by a newer one), not a failure so there is nothing to retry
+    bool canceled = false;
+
+    bool isOk() const { return error == QNetworkReply::NoError; }
+};
+
+// Where the eBay API lives. "api_base_url" in the eBay section of ebay.config.json points the dashboard at something else
+// (like the ebayMockServer build target), without it this is the real api.ebay.com
+QString ebayApiBaseUrl(const QJsonObject &ebayConfigJson);
+
+/*
+ * Single-flight request layer for the eBay API.
+ * Requests are keyed (normally by URL). If a request for a key is already running, a new caller is just added as another
+ * subscriber of that reply instead of sending a second request. The manager owns every QNetworkReply it creates, so a reply
+ * can never be overwritten or leaked, and anything still running when the manager is destroyed is aborted.
+ *
+ * Every request also belongs to an endpoint (the Trading API call name, or the URL path for the REST calls). Each endpoint
+ * has its own transfer timeout and latency histogram, and starting a request supersedes (cancels) any older request for
+ * the same endpoint that has a different key, since only the newest answer is going to be used anyway.
+ */
+class EbayRequestManager : public QObject
+{
+    Q_OBJECT
+public:
+    using Callback = std::function<void(const EbayResponse &response)>;
+    // Receives the body piece by piece as it arrives, the finished response then has an empty body
+    using ChunkHandler = std::function<void(const QByteArray &chunk)>;
+
+    explicit EbayRequestManager(QObject *parent = nullptr);
+
+    ~EbayRequestManager();
+
+    void get(const QString &key, const QNetworkRequest &request, Callback callback);
+
+    void post(const QString &key, const QNetworkRequest &request, const QByteArray &data, Callback callback, ChunkHandler onChunk = nullptr);
+
+    // Number of distinct requests currently on the wire (the in-flight gauge)
+    int inFlight() const;
+
+    bool isInFlight(const QString &key) const;
+
+    // Number of callers that were attached to an already running request instead of sending their own
+    qint64 coalescedCount() const;
+
+    // Transfer timeout for an endpoint, anything without its own uses defaultTimeoutMs
+    void setTimeout(const QString &endpoint, int msecs);
+
+    // Abort a running request, its subscribers get a response with canceled set
+    void cancel(const QString &key);
+
+    // How long the requests to each endpoint took, from sending to the last byte
+    const std::map<QString, LatencyHistogram> &latencies() const;
+
+    static QString endpointFor(const QNetworkRequest &request);
+
+    static const int defaultTimeoutMs = 30 * 1000;
+
+signals:
+    void inFlightChanged(int count);
+
+private:
+    // Makes sure a reply is disconnected, aborted if still running and deleted once it leaves the manager
+    struct ReplyDeleter
+    {
+        void operator()(QNetworkReply *reply) const;
+    };
+    using ReplyPtr = std::unique_ptr<QNetworkReply, ReplyDeleter>;
+
+    struct PendingRequest
+    {
+        ReplyPtr reply;
+        QList<Callback> subscribers;
+        ChunkHandler onChunk;
+        QString endpoint;
+        QElapsedTimer started;
+        int timeoutMs = 0;
+        bool canceled = false;
+    };
+
+    QNetworkAccessManager *manager;
+    std::map<QString, PendingRequest> pending;
+    std::map<QString, int> timeouts;
+    std::map<QString, LatencyHistogram> histograms;
+    qint64 coalesced = 0;
+
+    // Applies the endpoint's timeout and cancels older requests to the same endpoint
+    QNetworkRequest prepare(const QString &key, const QNetworkRequest &request);
+
+    // Returns true (and adds the subscriber) if a request for the key is already running
+    bool subscribe(const QString &key, Callback &callback);
+
+    void track(const QString &key, const QNetworkRequest &request, QNetworkReply *reply, Callback callback, ChunkHandler onChunk = nullptr);
+
+    void finish(const QString &key);
+};
+
+#endif // EBAYREQUESTMANAGER_H
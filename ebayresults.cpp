@@ -0,0 +1,52 @@
+#include "ebayresults.h"
+
+QJsonObject EbayMessageHeader::toJson() const {
+    return QJsonObject{
+        {"id", messageId},
+        {"subject", subject},
+        {"sender", sender},
+        {"received", receiveDate.toMSecsSinceEpoch()},
+        {"read", read}
+    };
+}
+
+EbayMessageHeader EbayMessageHeader::fromJson(const QJsonObject &json) {
+    EbayMessageHeader header;
+    header.messageId = json.value("id").toString();
+    header.subject = json.value("subject").toString();
+    header.sender = json.value("sender").toString();
+    header.receiveDate = QDateTime::fromMSecsSinceEpoch(json.value("received").toInteger());
+    header.read = json.value("read").toBool();
+    return header;
+}
+
+QJsonObject EbayMessages::toJson() const {
+    QJsonArray array;
+    for (const EbayMessageHeader &header : headers) {
+        array.append(header.toJson());
+    }
+    return QJsonObject{
+        {"messages", array},
+        {"synced_until", syncedUntil.isValid() ? syncedUntil.toMSecsSinceEpoch() : 0},
+        {"reconciled_at", reconciledAt.isValid() ? reconciledAt.toMSecsSinceEpoch() : 0}
+    };
+}
+
+EbayMessages EbayMessages::fromJson(const QJsonObject &json) {
+    EbayMessages messages;
+    QJsonArray array = json.value("messages").toArray();
+    messages.headers.reserve(array.size());
+    for (const QJsonValue &value : array) {
+        messages.headers.append(EbayMessageHeader::fromJson(value.toObject()));
+    }
+
+    qint64 syncedUntil = json.value("synced_until").toInteger();
+    if (syncedUntil > 0) {
+        messages.syncedUntil = QDateTime::fromMSecsSinceEpoch(syncedUntil, Qt::UTC);
+    }
+    qint64 reconciledAt = json.value("reconciled_at").toInteger();
+    if (reconciledAt > 0) {
+        messages.reconciledAt = QDateTime::fromMSecsSinceEpoch(reconciledAt, Qt::UTC);
+    }
+    return messages;
+}
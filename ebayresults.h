@@ -0,0 +1,54 @@
+#ifndef EBAYRESULTS_H
+#define EBAYRESULTS_H
+
+#include <QMetaType>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QVector>
+#include <QString>
+#include <QDateTime>
+
+#include <memory>
+
+/*
+ * Parsed results that are handed from the eBay network thread to the GUI thread.
+ * They are immutable once built, so both threads can hold on to the same object without any locking.
+ */
+
+// The body of a fulfillment GetOrders response
+using EbayOrdersPtr = std::shared_ptr<const QJsonObject>;
+
+// The parts of a GetMyMessages message header the dashboard actually shows
+struct EbayMessageHeader
+{
+    QString messageId;
+    QString subject;
+    QString sender;
+    QDateTime receiveDate;
+    bool read = false;
+
+    QJsonObject toJson() const;
+    static EbayMessageHeader fromJson(const QJsonObject &json);
+};
+
+using EbayMessageList = QVector<EbayMessageHeader>;
+
+// Every known message header (newest first) plus how far the message store has synced with eBay
+struct EbayMessages
+{
+    EbayMessageList headers;
+    // EndTime of the last successful GetMyMessages call
+    QDateTime syncedUntil;
+    // When the read flags of every message were last checked with a full (unwindowed) call
+    QDateTime reconciledAt;
+
+    // As JSON so it can be cached and sent to the other instances without any XML
+    QJsonObject toJson() const;
+    static EbayMessages fromJson(const QJsonObject &json);
+};
+using EbayMessagesPtr = std::shared_ptr<const EbayMessages>;
+
+Q_DECLARE_METATYPE(EbayOrdersPtr)
+Q_DECLARE_METATYPE(EbayMessagesPtr)
+
+#endif // EBAYRESULTS_H
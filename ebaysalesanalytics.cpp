@@ -0,0 +1,189 @@
+#include "ebaysalesanalytics.h"
+
+EbaySalesAnalytics::Totals &EbaySalesAnalytics::Totals::operator+=(const Totals &other) {
+    orders += other.orders;
+    units += other.units;
+    grossCents += other.grossCents;
+    taxCents += other.taxCents;
+    feeCents += other.feeCents;
+    return *this;
+}
+
+EbaySalesAnalytics::Totals &EbaySalesAnalytics::Totals::operator-=(const Totals &other) {
+    orders -= other.orders;
+    units -= other.units;
+    grossCents -= other.grossCents;
+    taxCents -= other.taxCents;
+    feeCents -= other.feeCents;
+    return *this;
+}
+
+bool EbaySalesAnalytics::Totals::operator==(const Totals &other) const {
+    return orders == other.orders && units == other.units && grossCents == other.grossCents
+           && taxCents == other.taxCents && feeCents == other.feeCents;
+}
+
+bool EbaySalesAnalytics::ingest(const EbayOrderStore &store) {
+    qint64 earliestChange = std::numeric_limits<qint64>::max();
+
+    for (int i = 0; i < store.orderCount(); i++) {
+        // Without an id or a date there's no telling whether it was counted already
+        if (store.orderId[i].isEmpty() || store.orderCreatedMs[i] == 0) {
+            continue;
+        }
+
+        auto existing = contributions.find(store.orderId[i]);
+
+        Contribution contribution;
+        contribution.day = QDateTime::fromMSecsSinceEpoch(store.orderCreatedMs[i], Qt::UTC).date().toJulianDay();
+        contribution.totals.orders = 1;
+        // A canceled order is still an order in the counts, it just didn't sell anything
+        if (!store.orderCanceled[i]) {
+            contribution.totals.units = store.orderUnits[i];
+            contribution.totals.grossCents = store.orderGrossCents[i];
+            contribution.totals.taxCents = store.orderTaxCents[i];
+            contribution.totals.feeCents = store.orderFeeCents[i];
+        }
+
+        // Most of every response is orders that were counted before and haven't changed
+        if (existing != contributions.end()) {
+            if (existing->day == contribution.day && existing->totals == contribution.totals) {
+                continue;
+            }
+            remove(existing->day, existing->totals, earliestChange);
+        }
+        add(contribution.day, contribution.totals, earliestChange);
+        contributions.insert(store.orderId[i], contribution);
+    }
+
+    if (earliestChange == std::numeric_limits<qint64>::max()) {
+        return false;
+    }
+    rebuildFrom(earliestChange);
+    return true;
+}
+
+EbaySalesAnalytics::Totals EbaySalesAnalytics::range(const QDate &first, const QDate &last) const {
+    if (prefix.empty()) {
+        return Totals();
+    }
+
+    // Outside of the days there are no sales, so just clamp to them
+    qint64 lastKnownDay = firstDay + qint64(prefix.size()) - 2;
+    qint64 from = qMax(first.toJulianDay(), firstDay);
+    qint64 to = qMin(last.toJulianDay(), lastKnownDay);
+    if (from > to) {
+        return Totals();
+    }
+
+    Totals totals = prefix[to - firstDay + 1];
+    totals -= prefix[from - firstDay];
+    return totals;
+}
+
+EbaySalesAnalytics::Totals EbaySalesAnalytics::lastDays(int days) const {
+    QDate today = QDate::currentDate();
+    return range(today.addDays(-days), today);
+}
+
+EbaySalesAnalytics::Totals EbaySalesAnalytics::monthToDate() const {
+    QDate today = QDate::currentDate();
+    return range(QDate(today.year(), today.month(), 1), today);
+}
+
+EbaySalesAnalytics::Totals EbaySalesAnalytics::monthToDateLastYear() const {
+    QDate today = QDate::currentDate();
+    return range(QDate(today.year() - 1, today.month(), 1), today.addYears(-1));
+}
+
+bool EbaySalesAnalytics::covers(const QDate &day) const {
+    return !prefix.empty() && firstDay <= day.toJulianDay();
+}
+
+QJsonObject EbaySalesAnalytics::toJson() const {
+    QJsonArray orders;
+    for (auto it = contributions.constBegin(); it != contributions.constEnd(); it++) {
+        orders.append(QJsonObject{
+            {"id", it.key()},
+            {"day", QDate::fromJulianDay(it->day).toString(Qt::ISODate)},
+            {"units", it->totals.units},
+            {"gross", it->totals.grossCents},
+            {"tax", it->totals.taxCents},
+            {"fees", it->totals.feeCents}
+        });
+    }
+    return QJsonObject{{"orders", orders}};
+}
+
+EbaySalesAnalytics EbaySalesAnalytics::fromJson(const QJsonObject &json) {
+    EbaySalesAnalytics analytics;
+    qint64 earliestChange = std::numeric_limits<qint64>::max();
+
+    for (auto&& value : json.value("orders").toArray()) {
+        QJsonObject order = value.toObject();
+        QDate day = QDate::fromString(order.value("day").toString(), Qt::ISODate);
+        if (!day.isValid() || order.value("id").toString().isEmpty()) {
+            continue;
+        }
+
+        Contribution contribution;
+        contribution.day = day.toJulianDay();
+        contribution.totals.orders = 1;
+        contribution.totals.units = order.value("units").toInteger();
+        contribution.totals.grossCents = order.value("gross").toInteger();
+        contribution.totals.taxCents = order.value("tax").toInteger();
+        contribution.totals.feeCents = order.value("fees").toInteger();
+
+        analytics.add(contribution.day, contribution.totals, earliestChange);
+        analytics.contributions.insert(order.value("id").toString(), contribution);
+    }
+
+    if (earliestChange != std::numeric_limits<qint64>::max()) {
+        analytics.rebuildFrom(earliestChange);
+    }
+    return analytics;
+}
+
+void EbaySalesAnalytics::add(qint64 day, const Totals &totals, qint64 &earliestChange) {
+    days[day] += totals;
+    earliestChange = qMin(earliestChange, day);
+}
+
+void EbaySalesAnalytics::remove(qint64 day, const Totals &totals, qint64 &earliestChange) {
+    auto it = days.find(day);
+    if (it == days.end()) {
+        return;
+    }
+    *it -= totals;
+    if (it->orders == 0) {
+        days.erase(it);
+    }
+    earliestChange = qMin(earliestChange, day);
+}
+
+void EbaySalesAnalytics::rebuildFrom(qint64 day) {
+    // A day before the first one shifts everything, so that is the one time it's all redone
+    if (prefix.empty() || day < firstDay) {
+        firstDay = day;
+        prefix.clear();
+    }
+
+    qint64 lastDay = firstDay;
+    for (auto it = days.constBegin(); it != days.constEnd(); it++) {
+        lastDay = qMax(lastDay, it.key());
+    }
+
+    qint64 size = lastDay - firstDay + 2;
+    qint64 start = qMin<qint64>(day - firstDay, qint64(prefix.size()) - 1);
+    if (start < 0) {
+        start = 0;
+    }
+    prefix.resize(size);
+    prefix[0] = Totals();
+
+    for (qint64 i = start; i < size - 1; i++) {
+        Totals next = prefix[i];
+        next += days.value(firstDay + i);
+        prefix[i + 1] = next;
+    }
+}
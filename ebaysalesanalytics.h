@@ -0,0 +1,90 @@
+#ifndef EBAYSALESANALYTICS_H
+#define EBAYSALESANALYTICS_H
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QHash>
+#include <QString>
+#include <QDate>
+#include <QDateTime>
+
+#include <vector>
+#include <limits>
+
+#include "ebayorderstore.h"
+
+/*
+ * Sales totals per day (orders, units, gross, tax and fees), kept up to date as order responses come in.
+ *
+ * Each order's contribution is remembered by order id, so seeing the same order again in the next response costs nothing,
+ * and a changed or canceled order only has its old contribution taken back out before the new one goes in. The days are
+ * also kept as running (prefix) sums, which makes the total for any range of days two lookups and a subtraction. Only the
+ * sums from the earliest changed day onwards are redone after a response.
+ *
+ * The orders call only reaches back to the start of last month, so the contributions are saved in ebay.sales.json and the
+ * history grows for as long as the dashboard runs (that is what the 90 day and year over year numbers come from).
+ *
+ * Days are UTC calendar days of the order's creation time (eBay's dates are UTC, and the order counts always started the
+ * day at UTC midnight). A canceled order still counts as an order, as it always has in the counts, but adds nothing to
+ * the units or the money.
+ */
+class EbaySalesAnalytics
+{
+public:
+    struct Totals
+    {
+        qint64 orders = 0;
+        qint64 units = 0;
+        qint64 grossCents = 0;
+        qint64 taxCents = 0;
+        qint64 feeCents = 0;
+
+        Totals &operator+=(const Totals &other);
+        Totals &operator-=(const Totals &other);
+        bool operator==(const Totals &other) const;
+    };
+
+    // Takes in a new response, returns true if any totals changed (so they need saving)
+    bool ingest(const EbayOrderStore &store);
+
+    // Totals of every day from first to last (both included), O(1)
+    Totals range(const QDate &first, const QDate &last) const;
+
+    // The days days before today plus today itself, so lastDays(7) is 8 calendar days like the "past 7 days" count has
+    // always been
+    Totals lastDays(int days) const;
+
+    Totals monthToDate() const;
+
+    // The same days of the month a year ago, for comparing with monthToDate()
+    Totals monthToDateLastYear() const;
+
+    // False when there is no history from before that day, so a comparison against it would be meaningless
+    bool covers(const QDate &day) const;
+
+    QJsonObject toJson() const;
+    static EbaySalesAnalytics fromJson(const QJsonObject &json);
+
+private:
+    struct Contribution
+    {
+        qint64 day = 0;
+        Totals totals;
+    };
+
+    QHash<QString, Contribution> contributions;
+    QHash<qint64, Totals> days;
+
+    // prefix[i] is the sum of every day before firstDay + i, so it has one more element than there are days
+    qint64 firstDay = 0;
+    std::vector<Totals> prefix;
+
+    void add(qint64 day, const Totals &totals, qint64 &earliestChange);
+    void remove(qint64 day, const Totals &totals, qint64 &earliestChange);
+
+    // Redo the running sums from day onwards, growing them if the range of days got wider
+    void rebuildFrom(qint64 day);
+};
+
+#endif // EBAYSALESANALYTICS_H
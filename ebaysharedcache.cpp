@@ -0,0 +1,162 @@
+#include "ebaysharedcache.h"
+
+EbaySharedCache::EbaySharedCache()
+{
+    memory.setKey("goalsDashboard.ebay.cache");
+}
+
+bool EbaySharedCache::attach() {
+    if (memory.attach()) {
+        // The creator sets the header up under the lock, but there is a moment between create() and it taking the lock.
+        // A header that is still all zeros is given a few tries before the segment counts as unusable
+        for (int attempt = 0; attempt < 50; attempt++) {
+            memory.lock();
+            const Header *header = static_cast<const Header*>(memory.constData());
+            quint32 headerMagic = header->magic;
+            bool sameLayout = headerMagic == magic && header->slotCount == slotCount && header->payloadBytes == payloadBytes;
+            memory.unlock();
+
+            if (sameLayout) {
+                return true;
+            }
+            if (headerMagic != 0) {
+                break;
+            }
+            QThread::msleep(10);
+        }
+
+        // Made by a build with a different layout (or never set up), don't touch it
+        qDebug() << "eBay shared cache segment has a different layout, not using it";
+        memory.detach();
+        return false;
+    }
+
+    qsizetype size = sizeof(Header) + qsizetype(slotCount) * sizeof(Slot);
+    if (!memory.create(size)) {
+        // Another instance created it in the meantime
+        if (memory.error() == QSharedMemory::AlreadyExists) {
+            return attach();
+        }
+        qDebug() << "Failed to create the eBay shared cache:" << memory.errorString();
+        return false;
+    }
+
+    // Set up every slot before writing the magic, attaching instances check it first
+    memory.lock();
+    std::memset(memory.data(), 0, size);
+    for (int i = 0; i < slotCount; i++) {
+        new (&slotAt(i)->seq) std::atomic<quint32>(0);
+    }
+    Header *header = static_cast<Header*>(memory.data());
+    header->slotCount = slotCount;
+    header->payloadBytes = payloadBytes;
+    header->magic = magic;
+    memory.unlock();
+    return true;
+}
+
+quint32 EbaySharedCache::publish(const QString &key, const QByteArray &payload, qint64 expiresAtMs) {
+    QByteArray keyUtf8 = key.toUtf8();
+    if (!memory.isAttached() || keyUtf8.size() > keyBytes || payload.size() > payloadBytes) {
+        return 0;
+    }
+
+    memory.lock();
+
+    // The slot that already has the key, otherwise the first empty one, otherwise the one that expires first
+    int chosen = -1;
+    int oldest = -1;
+    int home = homeSlot(keyUtf8);
+    for (int probe = 0; probe < slotCount; probe++) {
+        int index = (home + probe) % slotCount;
+        Slot *slot = slotAt(index);
+        if (slot->keyLength == quint32(keyUtf8.size()) && std::memcmp(slot->key, keyUtf8.constData(), keyUtf8.size()) == 0) {
+            chosen = index;
+            break;
+        }
+        if (slot->keyLength == 0) {
+            if (chosen == -1) {
+                chosen = index;
+            }
+            continue;
+        }
+        if (oldest == -1 || slot->expiresAtMs < slotAt(oldest)->expiresAtMs) {
+            oldest = index;
+        }
+    }
+    if (chosen == -1) {
+        chosen = oldest;
+    }
+
+    // Odd while writing, so readers know to throw away whatever they copy in the meantime
+    Slot *slot = slotAt(chosen);
+    slot->seq.fetch_add(1, std::memory_order_acq_rel);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->keyLength = keyUtf8.size();
+    std::memcpy(slot->key, keyUtf8.constData(), keyUtf8.size());
+    slot->expiresAtMs = expiresAtMs;
+    slot->payloadSize = payload.size();
+    std::memcpy(slot->payload, payload.constData(), payload.size());
+
+    quint32 version = slot->seq.fetch_add(1, std::memory_order_release) + 1;
+
+    memory.unlock();
+    return version;
+}
+
+bool EbaySharedCache::read(const QString &key, quint32 &version, QByteArray &payload) const {
+    QByteArray keyUtf8 = key.toUtf8();
+    if (!memory.isAttached() || keyUtf8.size() > keyBytes) {
+        return false;
+    }
+
+    char slotKey[keyBytes];
+    int home = homeSlot(keyUtf8);
+    for (int probe = 0; probe < slotCount; probe++) {
+        const Slot *slot = slotAt((home + probe) % slotCount);
+
+        // Keep copying until the copy was made while nobody was writing
+        while (true) {
+            quint32 before = slot->seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                QThread::yieldCurrentThread();
+                continue;
+            }
+
+            quint32 keyLength = qMin<quint32>(slot->keyLength, keyBytes);
+            std::memcpy(slotKey, slot->key, keyLength);
+            bool matches = keyLength == quint32(keyUtf8.size()) && std::memcmp(slotKey, keyUtf8.constData(), keyLength) == 0;
+
+            bool changed = matches && before != version;
+            QByteArray copy;
+            if (changed) {
+                copy = QByteArray(slot->payload, qMin<quint32>(slot->payloadSize, payloadBytes));
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->seq.load(std::memory_order_relaxed) != before) {
+                continue;
+            }
+
+            if (!matches) {
+                break;
+            }
+            if (changed) {
+                version = before;
+                payload = copy;
+            }
+            return changed;
+        }
+    }
+    return false;
+}
+
+EbaySharedCache::Slot *EbaySharedCache::slotAt(int index) const {
+    char *base = static_cast<char*>(const_cast<void*>(memory.constData()));
+    return reinterpret_cast<Slot*>(base + sizeof(Header) + qsizetype(index) * sizeof(Slot));
+}
+
+int EbaySharedCache::homeSlot(const QByteArray &key) {
+    return int(qHash(key) % slotCount);
+}
@@ -0,0 +1,73 @@
+#ifndef EBAYSHAREDCACHE_H
+#define EBAYSHAREDCACHE_H
+
+#include <QSharedMemory>
+#include <QByteArray>
+#include <QString>
+#include <QThread>
+#include <QDebug>
+
+#include <atomic>
+#include <cstring>
+#include <new>
+
+/*
+ * Optional shared memory tier for EbayCache, so the dashboard instances on one machine see each other's cache entries
+ * without writing and reparsing ebay.cache.json (the file is still written, but only so the cache survives restarts).
+ *
+ * The segment is a small fixed-slot hash table (open addressing on the key). Every slot has a sequence number used as a
+ * seqlock: a writer makes it odd, writes the slot and makes it even again, a reader copies the slot out and only keeps the
+ * copy if the number was even and didn't change meanwhile. So readers never take a lock and never wait on a writer for
+ * longer than one copy. Writers take the QSharedMemory lock between themselves.
+ *
+ * The sequence number doubles as the slot's version, so a reader that already has the current version doesn't copy anything.
+ */
+class EbaySharedCache
+{
+public:
+    static const int slotCount = 8;
+    static const int keyBytes = 256;
+    // Entries bigger than this stay local (and in the file)
+    static const int payloadBytes = 2 * 1024 * 1024;
+
+    EbaySharedCache();
+
+    // Attaches to the segment, creating it if this is the first instance
+    bool attach();
+
+    // Writes payload into the slot for key, returns the slot's new version (0 if the entry doesn't fit)
+    quint32 publish(const QString &key, const QByteArray &payload, qint64 expiresAtMs);
+
+    // If the slot for key holds a version other than version, copies the payload out, updates version and returns true
+    bool read(const QString &key, quint32 &version, QByteArray &payload) const;
+
+private:
+    static const quint32 magic = 0x45424331; // "EBC1"
+
+    struct Header
+    {
+        quint32 magic;
+        quint32 slotCount;
+        quint32 payloadBytes;
+    };
+
+    struct Slot
+    {
+        std::atomic<quint32> seq;
+        quint32 keyLength;
+        char key[keyBytes];
+        qint64 expiresAtMs;
+        quint32 payloadSize;
+        char payload[payloadBytes];
+    };
+
+    static_assert(std::atomic<quint32>::is_always_lock_free, "the seqlock has to work across processes");
+
+    QSharedMemory memory;
+
+    Slot *slotAt(int index) const;
+
+    static int homeSlot(const QByteArray &key);
+};
+
+#endif // EBAYSHAREDCACHE_H
@@ -0,0 +1,230 @@
+#include "ebaytokenmanager.h"
+
+namespace {
+// Refresh this long before the token actually expires so requests never go out with a token that is about to die
+const qint64 refreshMarginSecs = 5 * 60;
+}
+
+EbayTokenManager::EbayTokenManager(EbayRequestManager *requests, QObject *parent)
+    : QObject{parent}
+{
+    this->requests = requests;
+
+    refreshTimer.setSingleShot(true);
+    QObject::connect(&refreshTimer, &QTimer::timeout, this, &EbayTokenManager::refresh);
+}
+
+void EbayTokenManager::setConfig(const QJsonObject &ebayConfigJson) {
+    this->ebayConfigJson = ebayConfigJson;
+    negativeSecs = CachePolicies::fromConfig(ebayConfigJson).policyFor("token").negativeSecs;
+
+    QJsonObject ebay = ebayConfigJson.value("eBay").toObject();
+    token = ebay.value("access_token").toString();
+    tokenExpiresAt = QDateTime::fromString(ebay.value("expires_at").toString(), "ddd MMM d hh:mm:ss yyyy");
+
+    scheduleRefresh();
+}
+
+void EbayTokenManager::setToken(const QString &accessToken, const QDateTime &expiresAt) {
+    if (accessToken == token && expiresAt == tokenExpiresAt) {
+        return;
+    }
+
+    token = accessToken;
+    tokenExpiresAt = expiresAt;
+
+    // Keep the in memory copy of the config in sync in case this instance has to write it later
+    QJsonObject configCopy = ebayConfigJson["eBay"].toObject();
+    configCopy["access_token"] = token;
+    configCopy["expires_at"] = tokenExpiresAt.toString();
+    ebayConfigJson["eBay"] = configCopy;
+
+    scheduleRefresh();
+    flushWaiting();
+}
+
+void EbayTokenManager::setAutoRefresh(bool enabled) {
+    autoRefresh = enabled;
+    scheduleRefresh();
+}
+
+void EbayTokenManager::withToken(TokenCallback callback) {
+    if (!refreshing && isValid()) {
+        callback(token);
+        return;
+    }
+
+    // Wait for the refresh instead of sending the request with an expired token
+    waiting.append(std::move(callback));
+    if (autoRefresh && !refreshing) {
+        refresh();
+    }
+}
+
+QString EbayTokenManager::accessToken() const {
+    return token;
+}
+
+QDateTime EbayTokenManager::expiresAt() const {
+    return tokenExpiresAt;
+}
+
+bool EbayTokenManager::isValid() const {
+    return !token.isEmpty() && tokenExpiresAt.isValid() && QDateTime::currentDateTime() < tokenExpiresAt;
+}
+
+void EbayTokenManager::scheduleRefresh() {
+    refreshTimer.stop();
+    if (!autoRefresh || refreshing) {
+        return;
+    }
+
+    // Fire a little before the token expires (or right away if it already did)
+    qint64 msecs = QDateTime::currentDateTime().msecsTo(tokenExpiresAt.addSecs(-refreshMarginSecs));
+    if (!tokenExpiresAt.isValid() || msecs < 0) {
+        msecs = 0;
+    }
+    refreshTimer.start(msecs);
+}
+
+void EbayTokenManager::refresh() {
+    // A scheduled retry will call this again when it is time
+    if (refreshing || RetryPolicy::shared().isRetryPending("ebay:token")) {
+        return;
+    }
+
+    // The token endpoint kept failing, leave it alone until the circuit breaker lets a request through again
+    if (!RetryPolicy::shared().allowRequest("ebay:token")) {
+        RetryPolicy::shared().scheduleRetry("ebay:token", this, [=](){
+            this->refresh();
+        });
+        return;
+    }
+    refreshing = true;
+    refreshTimer.stop();
+
+    qDebug() << "refreshing access token";
+
+    QJsonObject ebay = ebayConfigJson.value("eBay").toObject();
+    QString tokenUrl = ebayApiBaseUrl(ebayConfigJson) + "/identity/v1/oauth2/token";
+    QNetworkRequest request(QUrl::fromUserInput(tokenUrl));
+
+    QString credentials = ebay.value("client_ID").toString() + ":";
+    credentials += ebay.value("client_secret").toString();
+
+    QByteArray base64Credentials = credentials.toUtf8().toBase64();
+
+    request.setRawHeader("Content-Type", "application/x-www-form-urlencoded");
+    request.setRawHeader("Authorization", "Basic " + base64Credentials);
+
+    QByteArray data = "grant_type=refresh_token";
+    data.append('&');
+    data.append("refresh_token=" + ebay.value("refresh_token").toString().toUtf8());
+
+    requests->post(tokenUrl, request, data, [this](const EbayResponse &response) {
+        handleRefresh(response);
+    });
+
+    qDebug() << "Sent POST refresh request";
+}
+
+void EbayTokenManager::handleRefresh(const EbayResponse &response) {
+    refreshing = false;
+
+    if (response.canceled) {
+        return;
+    }
+
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(response.body);
+    if (!response.isOk() || !jsonDoc.isObject() || !jsonDoc.object().contains("access_token")) {
+        qDebug() << "Error refreshing access token:" << response.errorString;
+
+        // Keep everyone queued and try again after a backoff (the circuit breaker holds it off if the endpoint keeps failing)
+        // The token policy's negative TTL is the shortest the endpoint is left alone after a failure
+        RetryPolicy::shared().failed("ebay:token");
+        RetryPolicy::shared().scheduleRetry("ebay:token", this, [=](){
+            this->refresh();
+        }, negativeSecs * 1000);
+        return;
+    }
+    RetryPolicy::shared().succeeded("ebay:token");
+
+    QJsonObject jsonObject = jsonDoc.object();
+
+    QDateTime expiringTime = QDateTime::currentDateTime();
+    qint64 expires_in = jsonObject.value("expires_in").toInteger();
+    expiringTime = expiringTime.addSecs(expires_in - 100);
+
+    QJsonObject configCopy = ebayConfigJson["eBay"].toObject();
+    configCopy["access_token"] = jsonObject["access_token"].toString();
+    configCopy["expires_at"] = expiringTime.toString();
+    ebayConfigJson["eBay"] = configCopy;
+
+    token = jsonObject["access_token"].toString();
+    tokenExpiresAt = expiringTime;
+
+    rewriteJson();
+    scheduleRefresh();
+
+    emit tokenChanged(token, tokenExpiresAt);
+
+    flushWaiting();
+}
+
+void EbayTokenManager::flushWaiting() {
+    if (refreshing || !isValid()) {
+        return;
+    }
+
+    // Swap the queue out first, a callback is allowed to ask for the token again
+    QList<TokenCallback> callbacks;
+    callbacks.swap(waiting);
+    for (const TokenCallback &callback : callbacks) {
+        callback(token);
+    }
+}
+
+void EbayTokenManager::rewriteJson() {
+    // Create a lockfile
+    QLockFile lockFile("ebay.config.json.lock");
+
+    // Try to lock said lockfile, the python side writes this file too and takes the same lock
+    if (!RetryPolicy::shared().tryLock(lockFile, "lock:ebay.config.json")) {
+
+        // If it can't access said lock file (somthing else has it locked already) try again after a backoff
+        RetryPolicy::shared().scheduleRetry("lock:ebay.config.json", this, [=](){
+            this->rewriteJson();
+        });
+        return;
+    }
+    RetryPolicy::shared().succeeded("lock:ebay.config.json");
+
+    // Read the file again under the lock and only change the access token in it. Anything else (a new refresh_token from
+    // refreshRefreshToken.py) may have been written since this instance read it and must not be overwritten
+    QJsonObject config = ebayConfigJson;
+    QFile current("ebay.config.json");
+    if (current.open(QIODevice::ReadOnly)) {
+        QJsonDocument currentDoc = QJsonDocument::fromJson(current.readAll());
+        current.close();
+        if (currentDoc.isObject()) {
+            config = currentDoc.object();
+        }
+    }
+    QJsonObject ebay = config["eBay"].toObject();
+    ebay["access_token"] = token;
+    ebay["expires_at"] = tokenExpiresAt.toString();
+    config["eBay"] = ebay;
+    // Whatever was new in the file is what this instance uses from now on too
+    ebayConfigJson = config;
+
+    // Lock was sucssessfull so rewrite ebay.config.json, through a temporary file that is renamed over it when complete
+    QSaveFile file("ebay.config.json");
+    QJsonDocument jsonDocument(config);
+    if (!file.open(QIODevice::WriteOnly) || file.write(jsonDocument.toJson()) < 0 || !file.commit()) {
+        // If unable to write the file let the GUI show that information
+        emit writeFailed("Failed to write ebay.config.json:\n" + file.errorString());
+    }
+
+    // Unlock the lockfile so something else can access the file at a later point
+    lockFile.unlock();
+}
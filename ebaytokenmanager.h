@@ -0,0 +1,87 @@
+#ifndef EBAYTOKENMANAGER_H
+#define EBAYTOKENMANAGER_H
+
+#include <QObject>
+
+#include <QNetworkRequest>
+
+#include <QJsonObject>
+#include <QJsonDocument>
+
+#include <QFile>
+#include <QSaveFile>
+#include <QLockFile>
+#include <QTimer>
+#include <QDateTime>
+#include <QList>
+
+#include <QDebug>
+
+#include <functional>
+
+#include "ebayrequestmanager.h"
+#include "retrypolicy.h"
+#include "cachepolicy.h"
+
+/*
+ * Keeps the eBay OAuth access token in memory and refreshes it in the background before it expires.
+ * Anything that needs a token asks for it through withToken(). Normally the callback runs straight away with the
+ * cached token, but while a refresh is running (or the token already expired) callers are queued and run as soon as
+ * the new token arrives instead of failing or going out with a stale token.
+ *
+ * Only the instance with auto refresh turned on (the eBay leader) talks to the token endpoint. Other instances are
+ * handed new tokens through setToken() so they never have to re-read ebay.config.json.
+ */
+class EbayTokenManager : public QObject
+{
+    Q_OBJECT
+public:
+    using TokenCallback = std::function<void(const QString &accessToken)>;
+
+    explicit EbayTokenManager(EbayRequestManager *requests, QObject *parent = nullptr);
+
+    // Takes the parsed contents of ebay.config.json (the refresh token, client id/secret and the last access token)
+    void setConfig(const QJsonObject &ebayConfigJson);
+
+    // Adopt a token that was refreshed somewhere else
+    void setToken(const QString &accessToken, const QDateTime &expiresAt);
+
+    void setAutoRefresh(bool enabled);
+
+    void withToken(TokenCallback callback);
+
+    QString accessToken() const;
+
+    QDateTime expiresAt() const;
+
+signals:
+    void tokenChanged(const QString &accessToken, const QDateTime &expiresAt);
+
+    // This can run off the GUI thread so errors are reported instead of shown
+    void writeFailed(const QString &error);
+
+private:
+    EbayRequestManager *requests;
+    QJsonObject ebayConfigJson;
+    QString token;
+    QDateTime tokenExpiresAt;
+    QTimer refreshTimer;
+    QList<TokenCallback> waiting;
+    bool autoRefresh = false;
+    bool refreshing = false;
+    int negativeSecs = 0;
+
+    bool isValid() const;
+
+    void scheduleRefresh();
+
+    void refresh();
+
+    void handleRefresh(const EbayResponse &response);
+
+    void flushWaiting();
+
+    void rewriteJson();
+};
+
+#endif // EBAYTOKENMANAGER_H
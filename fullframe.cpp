@@ -1,8 +1,11 @@
 #include "fullframe.h"
 
-FullFrame::FullFrame(QJsonObject* configJson, QWidget *parent)
+FullFrame::FullFrame(GoalModel* goals, ConfigStorage* storage, QWidget *parent)
     : QWidget{parent}, layout{new QGridLayout(this)}
 {
+    this->goals = goals;
+    this->storage = storage;
+
     // Set the margins on the outside of the grid of areas to be 0 (I do this so the layout can then define margins)
     setContentsMargins(0, 0, 0, 0);
 
@@ -13,30 +16,12 @@ FullFrame::FullFrame(QJsonObject* configJson, QWidget *parent)
     // Make the spacing between items to be 10 px
     layout->setSpacing(10);
 
-    // Color for the frames (gray slightly blue ish)
-    QColor areaFrameColor(203, 203, 213);
-
-    // Iterate over the QJsonArray within the QJsonObject
-    int row = 0;
-    int col = 0;
-    QStringList keys = configJson->keys();
-    for (const QString &key : keys) { // Iterate over the keys in the jsonObject aka the area names
-
-        // Create a new areaFrame and put it in the dictionary
-        areaFramesMap[key] = new AreaFrame(areaFrameColor, key, configJson, this);
-
-        // add the areaFrame to the layout
-        layout->addWidget(areaFramesMap[key], row, col);
-        if (col == 2){ // If the column is 2 aka this is the 3rd box from left to right
-            // Set the column back to 0 and increase the row count by 1
-            col = 0;
-            row++;
-        }
-        else {
-            // Increase the column count
-            col++;
-        }
+    // Make an areaFrame for every area and put them in the grid
+    shown = goals->snapshot();
+    for (const QString &key : shown->areaNames()) { // Iterate over the area names
+        areaFramesMap[key] = createAreaFrame(key);
     }
+    placeAreaFrames();
 
 }
 
@@ -48,8 +33,77 @@ void FullFrame::repopulateAll(){
 }
 
 void FullFrame::darkMode(){
+    isDarkMode = !isDarkMode;
+
     // Iterate over each of the areas and turn dark mode on/off
     for (auto it = areaFramesMap.begin(); it != areaFramesMap.end(); it++) {
         it.value()->darkMode();
     }
 }
+
+void FullFrame::refresh() {
+    ConfigSnapshotPtr latest = goals->snapshot();
+    if (latest == shown) {
+        return;
+    }
+    bool areasChanged = false;
+
+    // Remove the frames of areas that are gone
+    for (auto it = areaFramesMap.begin(); it != areaFramesMap.end();) {
+        if (latest->area(it.key()) == nullptr) {
+            layout->removeWidget(it.value());
+            it.value()->deleteLater();
+            it = areaFramesMap.erase(it);
+            areasChanged = true;
+        } else {
+            it++;
+        }
+    }
+
+    // New areas get a frame (which renders itself), the others only render again if their goals aren't the same pointer
+    for (const QString &key : latest->areaNames()) {
+        auto frame = areaFramesMap.constFind(key);
+        if (frame == areaFramesMap.constEnd()) {
+            areaFramesMap[key] = createAreaFrame(key);
+            areasChanged = true;
+        } else if (latest->area(key) != shown->area(key)) {
+            frame.value()->repopulate();
+        }
+    }
+
+    if (areasChanged) {
+        placeAreaFrames();
+    }
+    shown = latest;
+}
+
+AreaFrame *FullFrame::createAreaFrame(const QString &name) {
+    // Color for the frames (gray slightly blue ish)
+    QColor areaFrameColor(203, 203, 213);
+    AreaFrame *frame = new AreaFrame(areaFrameColor, name, goals, storage, this);
+
+    // A frame made after dark mode was turned on has to start out dark too
+    if (isDarkMode) {
+        frame->darkMode();
+    }
+    return frame;
+}
+
+void FullFrame::placeAreaFrames() {
+    int row = 0;
+    int col = 0;
+    for (auto it = areaFramesMap.begin(); it != areaFramesMap.end(); it++) {
+        // add the areaFrame to the layout
+        layout->removeWidget(it.value());
+        layout->addWidget(it.value(), row, col);
+        if (col == 2){ // If the column is 2 aka this is the 3rd box from left to right
+            // Set the column back to 0 and increase the row count by 1
+            col = 0;
+            row++;
+        }
+        else {
+            // Increase the column count
+            col++;
+        }
+    }
+}
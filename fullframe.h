@@ -20,12 +20,20 @@ class FullFrame : public QWidget
 private:
     QMap<QString, AreaFrame*> areaFramesMap;
     QGridLayout* layout;
-    QJsonObject* configJson;
+    GoalModel* goals;
+    ConfigStorage* storage;
+    // What the area frames show right now, refresh() compares the newest snapshot against it
+    ConfigSnapshotPtr shown;
     bool isDarkMode = false;
 
+    AreaFrame *createAreaFrame(const QString &name);
+
+    // Puts the area frames in the grid, three to a row in alphabetical order
+    void placeAreaFrames();
+
 
 public:
-    FullFrame(QJsonObject* configJson, QWidget *parent = nullptr);
+    FullFrame(GoalModel* goals, ConfigStorage* storage, QWidget *parent = nullptr);
     ~FullFrame(){
         for (auto it = areaFramesMap.begin(); it != areaFramesMap.end(); ++it) {
             it.value()->deleteLater();
@@ -34,6 +42,10 @@ public:
 
     void repopulateAll();
 
+    // Brings the frames up to the current snapshot: frames for new areas are made, frames of areas that are gone are
+    // removed and only the areas that changed are rendered again
+    void refresh();
+
     void darkMode();
 
 };
@@ -0,0 +1,55 @@
+#include "goal.h"
+
+void Goal::setTargetValue(const QString &value) {
+    targetValue = value;
+    target = value.toDouble(&targetIsNumber);
+}
+
+void Goal::setCurrentValue(const QString &value) {
+    currentValue = value;
+    current = value.toDouble(&currentIsNumber);
+}
+
+Goal Goal::fromJson(const QJsonObject &json) {
+    Goal goal;
+    goal.extra = json;
+
+    goal.id = json.value("id").toString();
+    goal.name = json.value("name").toString();
+    goal.setTargetValue(json.value("target_value").toString());
+    goal.setCurrentValue(json.value("current_value").toString());
+    goal.daysUntilRepeat = json.value("days_until_repeat").toString().toInt();
+    for (const char *field : {"id", "name", "target_value", "current_value", "days_until_repeat"}) {
+        goal.extra.remove(field);
+    }
+
+    // A date that can't be read stays in extra as it was, so it isn't lost
+    goal.startDate = ConfigSchema::parseDate(json.value("start_date").toString());
+    if (goal.startDate.isValid()) {
+        goal.extra.remove("start_date");
+    }
+    goal.endDate = ConfigSchema::parseDate(json.value("end_date").toString());
+    if (goal.endDate.isValid()) {
+        goal.extra.remove("end_date");
+    }
+    return goal;
+}
+
+QJsonObject Goal::toJson() const {
+    QJsonObject json = extra;
+    json["id"] = id;
+    json["name"] = name;
+    json["target_value"] = targetValue;
+    json["current_value"] = currentValue;
+    if (startDate.isValid()) {
+        json["start_date"] = ConfigSchema::formatDate(startDate);
+    }
+    if (endDate.isValid()) {
+        json["end_date"] = ConfigSchema::formatDate(endDate);
+    }
+    // Stored as a string, that is how the dashboard always wrote it
+    if (daysUntilRepeat > 0) {
+        json["days_until_repeat"] = QString::number(daysUntilRepeat);
+    }
+    return json;
+}
@@ -0,0 +1,36 @@
+#ifndef GOAL_H
+#define GOAL_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QDate>
+
+#include "configschema.h"
+
+// One goal, already parsed. The values are kept as typed (a target can be "$100"), with the number next to it when it is one
+struct Goal
+{
+    QString id;
+    QString name;
+    QString targetValue;
+    QString currentValue;
+    double target = 0;
+    bool targetIsNumber = false;
+    double current = 0;
+    bool currentIsNumber = false;
+    QDate startDate;
+    QDate endDate;
+    // 0 for goals that don't repeat
+    int daysUntilRepeat = 0;
+    // Whatever else the goal has in config.json (reminder_text for example), written back as it was
+    QJsonObject extra;
+
+    void setTargetValue(const QString &value);
+    void setCurrentValue(const QString &value);
+
+    // The goal as it is stored in config.json
+    static Goal fromJson(const QJsonObject &json);
+    QJsonObject toJson() const;
+};
+
+#endif // GOAL_H
@@ -0,0 +1,57 @@
+#include "goalindex.h"
+
+void GoalIndex::insert(const QString &area, const QString &id, const QDate &endDate) {
+    Area &index = areas[area];
+    if (index.byId.contains(id)) {
+        update(area, id, endDate);
+        return;
+    }
+    index.byId.insert(id, index.entries.insert(Entry{endDate, nextSequence++, id}).first);
+}
+
+void GoalIndex::update(const QString &area, const QString &id, const QDate &endDate) {
+    auto areaIt = areas.find(area);
+    if (areaIt == areas.end()) {
+        return;
+    }
+    auto it = areaIt->byId.find(id);
+    if (it == areaIt->byId.end() || (*it)->endDate == endDate) {
+        return;
+    }
+
+    // Keeps its sequence number, so among goals ending the same day it stays where it was
+    quint64 sequence = (*it)->sequence;
+    areaIt->entries.erase(*it);
+    *it = areaIt->entries.insert(Entry{endDate, sequence, id}).first;
+}
+
+void GoalIndex::remove(const QString &area, const QString &id) {
+    auto areaIt = areas.find(area);
+    if (areaIt == areas.end()) {
+        return;
+    }
+    auto it = areaIt->byId.find(id);
+    if (it == areaIt->byId.end()) {
+        return;
+    }
+    areaIt->entries.erase(*it);
+    areaIt->byId.erase(it);
+}
+
+void GoalIndex::removeArea(const QString &area) {
+    areas.remove(area);
+}
+
+QVector<QString> GoalIndex::ordered(const QString &area) const {
+    QVector<QString> ids;
+    auto it = areas.constFind(area);
+    if (it == areas.constEnd()) {
+        return ids;
+    }
+
+    ids.reserve(it->entries.size());
+    for (const Entry &entry : it->entries) {
+        ids.append(entry.id);
+    }
+    return ids;
+}
@@ -0,0 +1,55 @@
+#ifndef GOALINDEX_H
+#define GOALINDEX_H
+
+#include <QHash>
+#include <QVector>
+#include <QString>
+#include <QDate>
+
+#include <set>
+
+/*
+ * The goals of every area in end date order, kept up to date as goals are added, changed and removed instead of sorting
+ * anything. The pages and the menus go through this to show the goals soonest deadline first.
+ *
+ * Per area the index is an ordered set of (end date, sequence number, goal id), the sequence number keeps ties in the
+ * order the goals were added, plus the set entry of every goal id so a single goal can be found and moved in O(log n).
+ */
+class GoalIndex
+{
+public:
+    void insert(const QString &area, const QString &id, const QDate &endDate);
+
+    // Moves the goal to its place for the new end date (nothing happens if it didn't change)
+    void update(const QString &area, const QString &id, const QDate &endDate);
+
+    void remove(const QString &area, const QString &id);
+
+    void removeArea(const QString &area);
+
+    // The area's goal ids, soonest end date first
+    QVector<QString> ordered(const QString &area) const;
+
+private:
+    struct Entry
+    {
+        QDate endDate;
+        quint64 sequence;
+        QString id;
+
+        bool operator<(const Entry &other) const {
+            return endDate < other.endDate || (endDate == other.endDate && sequence < other.sequence);
+        }
+    };
+
+    struct Area
+    {
+        std::set<Entry> entries;
+        QHash<QString, std::set<Entry>::iterator> byId;
+    };
+
+    QHash<QString, Area> areas;
+    quint64 nextSequence = 0;
+};
+
+#endif // GOALINDEX_H
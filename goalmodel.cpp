@@ -0,0 +1,237 @@
+#include "goalmodel.h"
+
+bool GoalModel::load(const QJsonObject &config) {
+    bool idsAdded = false;
+    QMap<QString, std::vector<Goal>> loaded;
+    QHash<QString, Location> loadedIds;
+    QHash<QString, size_t> loadedHashes;
+    QMap<QString, QJsonArray> changedAreas;
+    QJsonObject loadedMetadata;
+
+    // Every area is hashed, one that hashes the same as when it was last loaded is kept exactly as it is (its goals, its
+    // place in the index and its part of the snapshot), only the areas that changed are parsed again
+    for (auto it = config.constBegin(); it != config.constEnd(); it++) {
+        if (!ConfigSchema::isAreaKey(it.key()) || !it.value().isArray()) {
+            loadedMetadata.insert(it.key(), it.value());
+            continue;
+        }
+
+        QJsonArray goalsArray = it.value().toArray();
+        size_t hash = qHash(QJsonDocument(goalsArray).toJson(QJsonDocument::Compact));
+        loadedHashes.insert(it.key(), hash);
+
+        auto previousHash = areaHashes.constFind(it.key());
+        if (previousHash != areaHashes.constEnd() && *previousHash == hash && areas.contains(it.key())) {
+            std::vector<Goal> &goals = loaded[it.key()];
+            goals = std::move(areas[it.key()]);
+            for (int i = 0; i < int(goals.size()); i++) {
+                loadedIds.insert(goals[i].id, Location{it.key(), i});
+            }
+        } else {
+            changedAreas.insert(it.key(), goalsArray);
+        }
+    }
+
+    for (auto it = changedAreas.constBegin(); it != changedAreas.constEnd(); it++) {
+        std::vector<Goal> &goals = loaded[it.key()];
+        goals.reserve(it.value().size());
+        for (const QJsonValue &value : it.value()) {
+            Goal goal = Goal::fromJson(value.toObject());
+            // Two goals with the same id (a copy pasted goal) can't both keep it
+            if (goal.id.isEmpty() || loadedIds.contains(goal.id)) {
+                goal.id = newId();
+                idsAdded = true;
+            }
+            loadedIds.insert(goal.id, Location{it.key(), int(goals.size())});
+            goals.push_back(goal);
+        }
+        dirtyAreas.insert(it.key());
+    }
+
+    // Only the changed areas move in the index. Goals that are gone (or went to another area) are taken out, the rest
+    // are inserted again which leaves the ones with the same end date where they were
+    for (auto it = changedAreas.constBegin(); it != changedAreas.constEnd(); it++) {
+        auto previous = areas.constFind(it.key());
+        if (previous != areas.constEnd()) {
+            for (const Goal &goal : previous.value()) {
+                auto loadedIt = loadedIds.constFind(goal.id);
+                if (loadedIt == loadedIds.constEnd() || loadedIt->area != it.key()) {
+                    index.remove(it.key(), goal.id);
+                }
+            }
+        }
+        for (const Goal &goal : loaded[it.key()]) {
+            index.insert(it.key(), goal.id, goal.endDate);
+        }
+    }
+    for (auto it = areas.constBegin(); it != areas.constEnd(); it++) {
+        if (!loaded.contains(it.key())) {
+            index.removeArea(it.key());
+            republish = true;
+        }
+    }
+    if (loadedMetadata != metadata) {
+        metadata = loadedMetadata;
+        republish = true;
+    }
+
+    areas.swap(loaded);
+    byId.swap(loadedIds);
+    areaHashes.swap(loadedHashes);
+
+    publish();
+    return idsAdded;
+}
+
+ConfigSnapshotPtr GoalModel::publish() {
+    ConfigSnapshotPtr previous = std::atomic_load(&current);
+    if (!republish && dirtyAreas.isEmpty()) {
+        return previous;
+    }
+
+    auto next = std::make_shared<ConfigSnapshot>();
+    next->versionNumber = nextVersion++;
+    next->metadata = metadata;
+    for (auto it = areas.constBegin(); it != areas.constEnd(); it++) {
+        auto shared = previous->areas.constFind(it.key());
+        if (!dirtyAreas.contains(it.key()) && shared != previous->areas.constEnd()) {
+            next->areas.insert(it.key(), *shared);
+        } else {
+            next->areas.insert(it.key(), areaSnapshot(it.key()));
+        }
+    }
+
+    republish = false;
+    dirtyAreas.clear();
+    ConfigSnapshotPtr published = next;
+    std::atomic_store(&current, published);
+    return published;
+}
+
+ConfigSnapshotPtr GoalModel::snapshot() const {
+    return std::atomic_load(&current);
+}
+
+QStringList GoalModel::areaNames() const {
+    return areas.keys();
+}
+
+QVector<const Goal*> GoalModel::ordered(const QString &area) const {
+    QVector<const Goal*> goals;
+    for (const QString &id : index.ordered(area)) {
+        goals.append(find(id));
+    }
+    return goals;
+}
+
+const Goal *GoalModel::find(const QString &id) const {
+    auto it = byId.constFind(id);
+    if (it == byId.constEnd()) {
+        return nullptr;
+    }
+    return &areas.find(it->area).value()[it->index];
+}
+
+QString GoalModel::areaOf(const QString &id) const {
+    return byId.value(id).area;
+}
+
+QString GoalModel::add(const QString &area, Goal goal) {
+    goal.id = newId();
+    std::vector<Goal> &goals = areas[area];
+    byId.insert(goal.id, Location{area, int(goals.size())});
+    index.insert(area, goal.id, goal.endDate);
+    goals.push_back(std::move(goal));
+    QString id = goals.back().id;
+    changed(area);
+    return id;
+}
+
+bool GoalModel::setCurrentValue(const QString &id, const QString &value) {
+    Goal *goal = findMutable(id);
+    if (goal == nullptr) {
+        return false;
+    }
+    goal->setCurrentValue(value);
+    changed(byId.value(id).area);
+    return true;
+}
+
+bool GoalModel::setTargetValue(const QString &id, const QString &value) {
+    Goal *goal = findMutable(id);
+    if (goal == nullptr) {
+        return false;
+    }
+    goal->setTargetValue(value);
+    changed(byId.value(id).area);
+    return true;
+}
+
+bool GoalModel::restart(const QString &id, const QDate &startDate, const QDate &endDate) {
+    Goal *goal = findMutable(id);
+    if (goal == nullptr) {
+        return false;
+    }
+    goal->startDate = startDate;
+    goal->endDate = endDate;
+    goal->setCurrentValue("0");
+    index.update(byId.value(id).area, id, endDate);
+    changed(byId.value(id).area);
+    return true;
+}
+
+bool GoalModel::remove(const QString &id) {
+    auto it = byId.find(id);
+    if (it == byId.end()) {
+        return false;
+    }
+    Location location = it.value();
+    byId.erase(it);
+    index.remove(location.area, id);
+
+    // Erased in place so the rest of the area keeps its order in the file, only the goals after it move down one.
+    // An area is a handful of goals, shifting them is nothing
+    std::vector<Goal> &goals = areas[location.area];
+    goals.erase(goals.begin() + location.index);
+    for (int i = location.index; i < int(goals.size()); i++) {
+        byId[goals[i].id].index = i;
+    }
+    changed(location.area);
+    return true;
+}
+
+void GoalModel::changed(const QString &area) {
+    dirtyAreas.insert(area);
+    // The area no longer matches what was loaded, if the same file comes back it has to be loaded again
+    areaHashes.remove(area);
+
+    // Readers of snapshot() see the change right away, not only once it has been written
+    publish();
+}
+
+Goal *GoalModel::findMutable(const QString &id) {
+    auto it = byId.constFind(id);
+    if (it == byId.constEnd()) {
+        return nullptr;
+    }
+    return &areas[it->area][it->index];
+}
+
+std::shared_ptr<const ConfigSnapshot::Area> GoalModel::areaSnapshot(const QString &area) const {
+    auto snapshot = std::make_shared<ConfigSnapshot::Area>();
+    const std::vector<Goal> &goals = areas.find(area).value();
+    snapshot->goals = goals;
+
+    snapshot->byId.reserve(int(goals.size()));
+    for (int i = 0; i < int(goals.size()); i++) {
+        snapshot->byId.insert(goals[i].id, i);
+    }
+    for (const QString &id : index.ordered(area)) {
+        snapshot->order.append(snapshot->byId.value(id));
+    }
+    return snapshot;
+}
+
+QString GoalModel::newId() {
+    return QUuid::createUuid().toString(QUuid::WithoutBraces);
+}
@@ -0,0 +1,108 @@
+#ifndef GOALMODEL_H
+#define GOALMODEL_H
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include <QStringList>
+#include <QString>
+#include <QDate>
+#include <QSet>
+#include <QUuid>
+
+#include <memory>
+#include <vector>
+
+#include "configschema.h"
+#include "goal.h"
+#include "configsnapshot.h"
+#include "goalindex.h"
+
+/*
+ * Every goal of every area, parsed once when config.json is loaded and only turned back into JSON when it is written.
+ *
+ * Each area is a std::vector<Goal> and every goal has an id (a uuid stored with the goal in config.json, goals from older
+ * files get one when they are loaded) with a hash from id to where the goal is. So finding and changing a goal are O(1),
+ * nothing is copied and nothing is searched by name. Removing one shifts the rest of its area down so the goals stay in
+ * the order they have in the file.
+ * The GoalIndex is kept alongside for the end date order the pages and menus use.
+ *
+ * The model itself belongs to the GUI thread, which is the only one changing goals. Everything that just reads them goes
+ * through snapshot(): publish() turns the changes since the last one into a new immutable ConfigSnapshot (copying only the
+ * areas that changed) and swaps it in atomically, so a reader on any thread gets a consistent version without a lock.
+ * load() and every change (add, setCurrentValue, ...) publish before they return, so snapshot() is never behind the model.
+ * Pointers handed out by the model's own find() and ordered() are only good until the next change.
+ */
+class GoalModel
+{
+public:
+    // Replaces the goals with the ones in config. Areas that didn't change are left alone, goals that keep their id and end
+    // date keep their place in the index.
+    // Returns true if any goal had no id yet (it got one, so the file should be written back). Publishes a new snapshot
+    bool load(const QJsonObject &config);
+
+    // Publishes the changes made since the last snapshot (if there are any) and returns the snapshot that is now current
+    ConfigSnapshotPtr publish();
+
+    // The last published snapshot, safe to call from any thread
+    ConfigSnapshotPtr snapshot() const;
+
+    // Alphabetical, like the keys of the JSON
+    QStringList areaNames() const;
+
+    // The area's goals, soonest end date first
+    QVector<const Goal*> ordered(const QString &area) const;
+
+    const Goal *find(const QString &id) const;
+
+    // The area's name for a goal id, empty if there is no such goal
+    QString areaOf(const QString &id) const;
+
+    // Adds the goal to area (creating the area if needed) and returns its new id
+    QString add(const QString &area, Goal goal);
+
+    bool setCurrentValue(const QString &id, const QString &value);
+
+    bool setTargetValue(const QString &id, const QString &value);
+
+    // New dates, and the progress starts over at 0
+    bool restart(const QString &id, const QDate &startDate, const QDate &endDate);
+
+    bool remove(const QString &id);
+
+private:
+    struct Location
+    {
+        QString area;
+        int index;
+    };
+
+    QMap<QString, std::vector<Goal>> areas;
+    QHash<QString, Location> byId;
+    // Everything at the top level that isn't an area (like the schema version)
+    QJsonObject metadata;
+    GoalIndex index;
+    // Hash of each area's JSON when it was loaded, an area that comes back the same isn't loaded again
+    QHash<QString, size_t> areaHashes;
+    // Areas changed since the last publish
+    QSet<QString> dirtyAreas;
+    // Something outside the areas changed (the metadata, or an area is gone)
+    bool republish = false;
+    quint64 nextVersion = 1;
+    // Only ever read and written through std::atomic_load/std::atomic_store
+    ConfigSnapshotPtr current = std::make_shared<const ConfigSnapshot>();
+
+    // Marks area as changed and publishes
+    void changed(const QString &area);
+
+    Goal *findMutable(const QString &id);
+
+    std::shared_ptr<const ConfigSnapshot::Area> areaSnapshot(const QString &area) const;
+
+    static QString newId();
+};
+
+#endif // GOALMODEL_H
@@ -6,10 +6,13 @@
  ********************************************************************************************************/
 
 GoalsDashboard::GoalsDashboard(QWidget *parent)
-    : QMainWindow(parent), centralWidget(this)
+    : QMainWindow(parent), storage(&goals, &io), centralWidget(this)
 {
-    // load config json information
-    loadJson();
+    // load config json information. It's read on the I/O thread, so the window is up before the goals are in it.
+    // The daily jobs need the goals, so they go once the goals are there (and by then the window has been painted)
+    loadJson(QString(), [this]() {
+        QTimer::singleShot(0, this, &GoalsDashboard::dailyTimerFinished);
+    });
 
     // Set styling
     QDate aprilFirst = QDate(QDate::currentDate().year(), 4, 1);
@@ -40,11 +43,8 @@ GoalsDashboard::GoalsDashboard(QWidget *parent)
         setPalette(pal);
     }
 
-    // Add a watcher to the config.json file and connect it so that when it changes it reloads the file and populates areas
-    watcher.addPath("config.json");
-    QObject::connect(&watcher, &QFileSystemWatcher::fileChanged, this, [&](const QString& path) {
-        fileChanged();
-    });
+    // When the goal files change reload them and populate areas (with config.d/ only the area whose file changed)
+    QObject::connect(&storage, &ConfigStorage::changed, this, &GoalsDashboard::fileChanged);
 
     // Create a QMenuBar and add it to the GoalsDashboard
     QMenuBar *menuBar = this->menuBar();
@@ -57,13 +57,12 @@ GoalsDashboard::GoalsDashboard(QWidget *parent)
     // Connect when an action in the edit menu is triggered that the function is called
     connect(editGoalMenu, &QMenu::triggered, this, [=](QAction *action) {
         QMenu *areaMenu = qobject_cast<QMenu*>(action->parent());
-        editGoalsGoalSelected(areaMenu->title(), action->text());
+        editGoalsGoalSelected(areaMenu->title(), action->data().toString());
     });
 
     // Connect when an action in the remove menu is triggered that the function is called
     connect(removeGoalMenu, &QMenu::triggered, this, [=](QAction *action) {
-        QMenu *areaMenu = qobject_cast<QMenu*>(action->parent());
-        removeGoalSelected(areaMenu->title(), action->text());
+        removeGoalSelected(action->data().toString());
     });
 
     // Create various actions
@@ -71,12 +70,25 @@ GoalsDashboard::GoalsDashboard(QWidget *parent)
     QAction *darkModeAction = menuBar->addAction("Dark Mode");
     QAction *ebayAction = menuBar->addAction("eBay Mode");
     QAction *refreshAction = menuBar->addAction("refresh refresh token");
+    QAction *diagnosticsAction = menuBar->addAction("Diagnostics");
+
+    // Moving between config.json and one file per area in config.d/
+    QMenu *configFilesMenu = menuBar->addMenu("Config Files");
+    QAction *splitAction = configFilesMenu->addAction("Split into one file per area (config.d)");
+    QAction *combineAction = configFilesMenu->addAction("Combine into config.json");
 
     // Connect actions to slots (a type of function)
     QObject::connect(jsonToCsvAction, &QAction::triggered, this, &GoalsDashboard::jsonToCsv);
     QObject::connect(darkModeAction, &QAction::triggered, this, &GoalsDashboard::darkMode);
     QObject::connect(ebayAction, &QAction::triggered, this, &GoalsDashboard::ebayMode);
     QObject::connect(refreshAction, &QAction::triggered, this, &GoalsDashboard::refreshRefreshToken);
+    QObject::connect(splitAction, &QAction::triggered, this, &GoalsDashboard::splitConfig);
+    QObject::connect(combineAction, &QAction::triggered, this, &GoalsDashboard::combineConfig);
+    QObject::connect(diagnosticsAction, &QAction::triggered, this, [=]() {
+        if (ebayFrame != nullptr) {
+            ebayFrame->showDiagnostics();
+        }
+    });
 
     // Set the Window Icon to be BYU Y
     QIcon icon("BYU.png");
@@ -85,18 +97,17 @@ GoalsDashboard::GoalsDashboard(QWidget *parent)
     // Create a daily timer and connect it so that the backup/history will be updated daily
     myDailyTimer = new QTimer(this);
     connect(myDailyTimer, &QTimer::timeout, this, &GoalsDashboard::dailyTimerFinished);
-    dailyTimerFinished();
     startDailyTimer();
 
     // Create the fullFrame and set it to be what is the center of view
-    this->fullFrame = new FullFrame(&configJson, this);
+    this->fullFrame = new FullFrame(&goals, &storage, this);
 
     setCentralWidget(&centralWidget);
 
     // setLayout(&layout);
     centralWidget.addWidget(fullFrame);
 
-    ebayFrame = new EbayFrame(&configJson, this);
+    ebayFrame = new EbayFrame(&goals, &storage, &io, this);
     centralWidget.addWidget(ebayFrame);
 
     // add sample rates to dictionary for the various wav files (see checkSequence)
@@ -189,34 +200,6 @@ void GoalsDashboard::checkSequence() {
     audio->start(&sourceFile);
 }
 
-void GoalsDashboard::rewriteJson() {
-    // Create a lockfile
-    QLockFile lockFile("config.json.lock");
-
-    // Try to lock said lockfile for 1000 milliseconds .1 second
-    if (!lockFile.tryLock(1000)) {
-
-        // If it can't access said lock file (somthing else has it locked already try again in 5000 milliseconds
-        QTimer::singleShot(5000, this, [=](){
-            this->rewriteJson();
-        });
-        return;
-    }
-
-    // Lock was sucssessfull so open the config.json file and rewrite it
-    QFile file("config.json");
-    if (file.open(QIODevice::WriteOnly)) {
-        QJsonDocument jsonDocument(configJson);
-        file.write(jsonDocument.toJson());
-        file.close();
-    } else { // If unable to open the file for writing show a messagebox with that information
-        QMessageBox::critical(nullptr, "Error", "Failed to open file for writing:\n" + file.errorString());
-    }
-
-    // Unlock the lockfile so something else can access the file at a later point
-    lockFile.unlock();
-}
-
 void GoalsDashboard::makeBackup() {
     // Create today's date as a string
     QString date = QDate::currentDate().toString("yyyy-MM-dd");
@@ -225,48 +208,97 @@ void GoalsDashboard::makeBackup() {
     QString backupDirPath = "backups";
     QString backupFilePath = backupDirPath + "/file_backup_" + date + ".json";
 
-    // Check if the backup file already exists
-    if (QFile::exists(backupFilePath)) {
-        return;
-    }
+    // With config.d/ the backup is still one file, made from what is loaded (taken now, the copy happens on the I/O thread)
+    ConfigSnapshotPtr snapshot = storage.isSharded() ? goals.snapshot() : nullptr;
 
-    // Ensure the backup directory exists
-    QDir dir;
-    if (!dir.exists(backupDirPath)) {
-        dir.mkpath(backupDirPath);
-    }
+    io.run([backupDirPath, backupFilePath, snapshot]() -> QString {
+        // Check if the backup file already exists
+        if (QFile::exists(backupFilePath)) {
+            return QString();
+        }
 
-    // Copy the file to create the backup
-    if (!QFile::copy("config.json", backupFilePath)) {
-        QMessageBox::critical(nullptr, "Error", "Failed to create backup\n");
-    }
+        // Ensure the backup directory exists
+        QDir dir;
+        if (!dir.exists(backupDirPath)) {
+            dir.mkpath(backupDirPath);
+        }
+
+        if (snapshot != nullptr) {
+            QSaveFile backupFile(backupFilePath);
+            if (!backupFile.open(QIODevice::WriteOnly) || backupFile.write(QJsonDocument(snapshot->toJson()).toJson()) < 0 || !backupFile.commit()) {
+                return "Failed to create backup\n";
+            }
+            return QString();
+        }
+
+        // Copy the file to create the backup
+        if (!QFile::copy("config.json", backupFilePath)) {
+            return "Failed to create backup\n";
+        }
+        return QString();
+    }, this, [](const QString &error) {
+        if (!error.isEmpty()) {
+            QMessageBox::critical(nullptr, "Error", error);
+        }
+    });
 }
 
 void GoalsDashboard::updateHistory() {
+    // Today's values are taken from the goals as they are now, all of the file work happens on the I/O thread
+    ConfigSnapshotPtr snapshot = goals.snapshot();
+    io.run([snapshot]() {
+        return appendHistory(snapshot);
+    }, this, [this](const IoQueue::WriteResult &result) {
+        if (!result.locked) {
+            // If it can't access said lock file (somthing else has it locked already) try again after a backoff
+            RetryPolicy::shared().scheduleRetry("lock:history.json", this, [=](){
+                this->updateHistory();
+            });
+            return;
+        }
+        RetryPolicy::shared().succeeded("lock:history.json");
+
+        if (!result.error.isEmpty()) {
+            QMessageBox::critical(nullptr, "Error", result.error);
+        }
+    });
+}
+
+IoQueue::WriteResult GoalsDashboard::appendHistory(ConfigSnapshotPtr snapshot) {
+    IoQueue::WriteResult result;
+
+    // The lock is held from the read to the write, otherwise another instance could add its day in between and it would
+    // be lost when this one writes
+    QLockFile lockFile("history.json.lock");
+    if (!RetryPolicy::shared().tryLock(lockFile, "lock:history.json")) {
+        result.locked = false;
+        return result;
+    }
+
     // Load history.json file
     QFile historyFile("history.json");
     historyFile.open(QFile::ReadOnly);
     QJsonDocument historyDoc = QJsonDocument::fromJson(historyFile.readAll());
     historyFile.close();
 
-    // Parse JSON data
+    // Parse JSON data, the goals in the history are matched by start date so their dates have to be in the same format
     QJsonObject historyObject = historyDoc.object();
+    ConfigSchema::migrate(historyObject);
 
     // Check if the last_changed date is today
     QDate today = QDate::currentDate();
     if (historyObject.value("last_changed").toString() == today.toString(Qt::ISODate)) {
         // If the last_changed date is today, return without doing anything
-        return;
+        return result;
     }
 
-    // Append current goals to history
-    for (const QString& category : configJson.keys()) { // Iterate over the categories
-        // Get the goals in the current config file and the history file for that category
-        QJsonArray currentCategoryArray = configJson.value(category).toArray();
+    // Append current goals to history, from one snapshot so every area is from the same version
+    for (const QString& category : snapshot->areaNames()) { // Iterate over the categories
+        // Get the history file's goals for that category
         QJsonArray historyCategoryArray = historyObject.value(category).toArray();
 
-        for (const QJsonValue& currentValue : currentCategoryArray) { // Iterate over the goals in the current config file
-            QJsonObject currentGoal = currentValue.toObject();
+        for (const Goal *currentGoal : snapshot->ordered(category)) { // Iterate over the goals in the current config
+            QString startDate = ConfigSchema::formatDate(currentGoal->startDate);
             bool goalExistsInHistory = false;
 
             // Iterate over the goals in the history config file
@@ -274,15 +306,15 @@ void GoalsDashboard::updateHistory() {
                 QJsonObject historyGoal = historyCategoryArray[i].toObject();
 
                 // Check if the name of the currentGoal and the History goal are the same && the starting dates are the same for both to ensure that they are the same goals
-                if (historyGoal.value("name") == currentGoal.value("name") && historyGoal.value("start_date") == currentGoal.value("start_date")) {
+                if (historyGoal.value("name").toString() == currentGoal->name && historyGoal.value("start_date").toString() == startDate) {
                     // Append the current_value to the daily_values array
                     QJsonArray dailyValues = historyGoal.value("daily_values").toArray();
-                    dailyValues.append(currentGoal.value("current_value"));
+                    dailyValues.append(currentGoal->currentValue);
                     historyGoal.insert("daily_values", dailyValues);
 
                     // Check if today is the day after the goal's end date. If it is add the progress_at_end_date value
-                    if(QDate::currentDate() == QDate::fromString(historyGoal.value("end_date").toString(), "ddd MMM d yyyy").addDays(1)) {
-                        historyGoal.insert("progress_at_end_date", currentGoal.value("current_value"));
+                    if(QDate::currentDate() == ConfigSchema::parseDate(historyGoal.value("end_date").toString()).addDays(1)) {
+                        historyGoal.insert("progress_at_end_date", currentGoal->currentValue);
                     }
 
 
@@ -298,17 +330,17 @@ void GoalsDashboard::updateHistory() {
             if (!goalExistsInHistory) {
                 // Create a new goal with the current_value in the daily_values array
                 QJsonObject newGoal;
-                newGoal.insert("name", currentGoal.value("name"));
-                newGoal.insert("start_date", currentGoal.value("start_date"));
-                newGoal.insert("end_date", currentGoal.value("end_date"));
-                newGoal.insert("target_value", currentGoal.value("target_value"));
+                newGoal.insert("name", currentGoal->name);
+                newGoal.insert("start_date", startDate);
+                newGoal.insert("end_date", ConfigSchema::formatDate(currentGoal->endDate));
+                newGoal.insert("target_value", currentGoal->targetValue);
                 QJsonArray dailyValues;
-                dailyValues.append(currentGoal.value("current_value"));
+                dailyValues.append(currentGoal->currentValue);
                 newGoal.insert("daily_values", dailyValues);
 
                 // In the off chance that today is the day after the goal's end date, add the progress_at_end_date value
-                if(QDate::currentDate() == QDate::fromString(currentGoal.value("end_date").toString(), "ddd MMM d yyyy").addDays(1)) {
-                    newGoal.insert("progress_at_end_date", currentGoal.value("current_value").toString());
+                if(QDate::currentDate() == currentGoal->endDate.addDays(1)) {
+                    newGoal.insert("progress_at_end_date", currentGoal->currentValue);
                 }
                 // Add the goal to the history array
                 historyCategoryArray.append(newGoal);
@@ -324,29 +356,15 @@ void GoalsDashboard::updateHistory() {
 
 
 
-    // Write the updated JSON data back to the history.json file
-    // Create a lockfile
-    QLockFile lockFile("history.json.lock");
-    // Try to lock said lockfile for 1000 milliseconds .1 second
-    if (!lockFile.tryLock(1000)) {
-        // If it can't access said lock file (somthing else has it locked already try again in 5000 milliseconds
-        QTimer::singleShot(10000, this, [=](){
-            this->updateHistory();
-        });
-        return;
-    }
-
-    // Lock was sucssessfull so open the config.json file and rewrite it
-    if (historyFile.open(QIODevice::WriteOnly)) {
-
-        historyFile.write(QJsonDocument(historyObject).toJson());
-        historyFile.close();
-    } else {
-        QMessageBox::critical(nullptr, "Error", "Failed to open file for writing:\n" + historyFile.errorString());
+    // Write the updated JSON data back to the history.json file, replacing it in one go
+    QSaveFile historySaveFile("history.json");
+    if (!historySaveFile.open(QIODevice::WriteOnly) || historySaveFile.write(QJsonDocument(historyObject).toJson()) < 0 || !historySaveFile.commit()) {
+        result.error = "Failed to write history.json:\n" + historySaveFile.errorString();
     }
 
     // Unlock the lockFile
     lockFile.unlock();
+    return result;
 }
 
 void GoalsDashboard::startDailyTimer(){
@@ -378,49 +396,28 @@ void GoalsDashboard::startDailyTimer(){
 }
 
 void GoalsDashboard::updateRepeating() {
-    // Go over each category
-    bool anyUpdated = false;
-    for (QString& category : configJson.keys()) {
-        QJsonArray currentCategoryArray = configJson.value(category).toArray();
-
-        // Go over each goal within the category
-        for (auto&& currentValue : currentCategoryArray) {
-            QJsonObject currentGoal = currentValue.toObject();
-
-            if (currentGoal.contains("days_until_repeat")){
-                if (QDate::fromString(currentGoal.value("end_date").toString()) < QDate::currentDate()){
-                    int daysUntilRepeat = currentGoal.value("days_until_repeat").toString().toInt();
-                    currentGoal["start_date"] = QDate::currentDate().toString();
-                    currentGoal["current_value"] = "0";
-                    currentGoal["end_date"] = QDate::currentDate().addDays(daysUntilRepeat -1 ).toString(); //subtract one from daysUntilRepeat so that it counts the day that it currently is as one of the days
-                    anyUpdated = true;
-
-                    currentValue = currentGoal;
-                }
-            }
-        }
-
-
-        int n = currentCategoryArray.size();
-        for (int i = 0; i < n -1; i++) {
-            for (int j = 0; j < n - i - 1; j++) {
-                QJsonObject obj1 = currentCategoryArray[j].toObject();
-                QJsonObject obj2 = currentCategoryArray[j + 1].toObject();
-                QDate date1 = QDate::fromString(obj1.value("end_date").toString(), "ddd MMM d yyyy");
-                QDate date2 = QDate::fromString(obj2.value("end_date").toString(), "ddd MMM d yyyy");
-                if (date1 > date2) {
-                    currentCategoryArray[j] = obj2;
-                    currentCategoryArray[j + 1] = obj1;
-                }
+    // Find the repeating goals that are over first, restarting one moves it in the order being gone over
+    QVector<QString> finished;
+    for (const QString& category : goals.areaNames()) {
+        for (const Goal *goal : goals.ordered(category)) {
+            if (goal->daysUntilRepeat > 0 && goal->endDate < QDate::currentDate()) {
+                finished.append(goal->id);
             }
         }
+    }
 
-
-        configJson[category] = currentCategoryArray;
+    // Start each of them over from today
+    QSet<QString> areas;
+    for (const QString& id : finished) {
+        int daysUntilRepeat = goals.find(id)->daysUntilRepeat;
+        areas.insert(goals.areaOf(id));
+        //subtract one from daysUntilRepeat so that it counts the day that it currently is as one of the days
+        goals.restart(id, QDate::currentDate(), QDate::currentDate().addDays(daysUntilRepeat -1 ));
     }
 
-    if (anyUpdated){
-        rewriteJson();
+    // Only the areas that had a goal start over are written
+    for (const QString& area : areas) {
+        storage.writeArea(area);
     }
 }
 
@@ -472,49 +469,69 @@ void GoalsDashboard::invertAll() {
 
 }
 
-void GoalsDashboard::loadJson() {
+void GoalsDashboard::loadJson(const QString &area, std::function<void()> loaded) {
 
-    qDebug() << "loading config.json";
+    qDebug() << "loading goals" << area;
 
-    QLockFile lockFile("config.json.lock");
-    lockFile.setStaleLockTime(10000);
-    if (!lockFile.tryLock(1000)) {
-        qCritical() << "Failed to acquire lock for config.json";
-        return;
-    }
+    // Read the goals, all of them or only the area that changed. The files are read on the I/O thread, the goals are
+    // updated back here
+    storage.read(area, [this, loaded](const QJsonObject &config, const QString &error) {
+        if (!error.isEmpty()) {
+            qCritical() << error;
+        } else {
+            try {
+                applyJson(config);
+            } catch (std::exception &e) {
+                qCritical() << "error while loading goals file" << e.what();
+            } catch (...) {
+                qCritical() << "Unknown exception caught while loading goals config";
+            }
+        }
 
-    // open the file
-    QFile file("config.json");
-    QJsonObject jsonObj;
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        lockFile.unlock();
-        qCritical() << "Failed to open file: config.json";
-        return;
+        if (loaded) {
+            loaded();
+        }
+    });
+}
+
+void GoalsDashboard::applyJson(QJsonObject jsonObj) {
+    // Files from before the schema version get their dates converted once, and written back so it only happens once.
+    // The original is kept next to it in case anything went wrong (the copy is queued before the write, so it's the original)
+    bool migrated = ConfigSchema::migrate(jsonObj);
+    if (migrated) {
+        qDebug() << "migrated config.json to schema version" << ConfigSchema::currentVersion;
+        if (!storage.isSharded()) {
+            io.run([]() {
+                QFile::copy("config.json", "config.json.v1.bak");
+            });
+        }
     }
 
-    // put the data into a buffer (byte array)
-    QByteArray jsonData = file.readAll();
-    file.close();
-    lockFile.unlock();
+    // Goals from before they had ids get one here, that also has to be written back so the ids stay the same
+    quint64 version = goals.snapshot()->version();
+    bool idsAdded = goals.load(jsonObj);
+    if (migrated || idsAdded) {
+        storage.write();
+    }
 
-    // Try to parse the QByteArray as a jsonDoc
-    QJsonParseError error;
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData, &error);
-    if (jsonDoc.isNull()) {
-        qCritical() << "Failed to parse JSON:" << error.errorString();
+    // The menus only have to be rebuilt if something actually changed
+    if (goals.snapshot()->version() == version) {
         return;
     }
-
-    // Convert the jsonDocument to a jsonObject
-    jsonObj = jsonDoc.object();
-    configJson =  jsonObj;
-
     if (editGoalMenu != nullptr) {
         populateMenus();
     }
+
+    // Only the areas that changed are rendered again, and areas that were added or removed get or lose their frame
+    if (fullFrame != nullptr) {
+        fullFrame->refresh();
+    }
+    if (ebayFrame != nullptr) {
+        ebayFrame->repopulateGoals();
+    }
 }
 
-void GoalsDashboard::editGoalsGoalSelected(QString areaName, QString goalName) {
+void GoalsDashboard::editGoalsGoalSelected(QString areaName, QString goalId) {
     // Create a new QDialog
     std::unique_ptr<QDialog> openDialog(new QDialog);
     openDialog->setWindowTitle("Edit/Create Goals");
@@ -527,7 +544,7 @@ void GoalsDashboard::editGoalsGoalSelected(QString areaName, QString goalName) {
     QLineEdit *newGoalNameEdit;
 
     // If the user want's to make a new goal
-    if (goalName == "Add new goal") {
+    if (goalId.isEmpty()) {
         // Create a label and add it to the layout
         QLabel *newGoalName = new QLabel("New Goal's Name:", openDialog.get());
         layout->addWidget(newGoalName);
@@ -537,21 +554,10 @@ void GoalsDashboard::editGoalsGoalSelected(QString areaName, QString goalName) {
         newGoalNameEdit->setPlaceholderText("Enter name here...");
         layout->addWidget(newGoalNameEdit);
     }
-    else {
-        // Define the goalsArray to find the goal that will be edited
-        QJsonArray goalsArray = configJson.value(areaName).toArray();
-
-        // Iterate over the goals in the goalsArray
-        for (const auto& goal : goalsArray) {
-            QJsonObject goalObj = goal.toObject();
-
-            // Check if the goal is the desired goal
-            if (goalObj.value("name") == goalName) {
-                // Define a label and add it to the label
-                QLabel *currentTarget = new QLabel("Current Target: " + goalObj.value("target_value").toString(), openDialog.get());
-                layout->addWidget(currentTarget);
-            }
-        }
+    else if (const Goal *goal = goals.snapshot()->find(goalId)) {
+        // Define a label and add it to the label
+        QLabel *currentTarget = new QLabel("Current Target: " + goal->targetValue, openDialog.get());
+        layout->addWidget(currentTarget);
     }
     // Create a label and add it to the layout
     QLabel *newTarget = new QLabel("Target:", openDialog.get());
@@ -567,7 +573,7 @@ void GoalsDashboard::editGoalsGoalSelected(QString areaName, QString goalName) {
     repeatCheckBox->hide();
 
     // If we are creating a new goal show the checkbox
-    if (goalName == "Add new goal") {
+    if (goalId.isEmpty()) {
         layout->addWidget(repeatCheckBox);
         repeatCheckBox->show();
     }
@@ -595,7 +601,7 @@ void GoalsDashboard::editGoalsGoalSelected(QString areaName, QString goalName) {
     }
 
     // Check if we are creating a new goal
-    if (goalName == "Add new goal") {
+    if (goalId.isEmpty()) {
         // Connect the checkBox so we can show various things if it is checked or not
         QObject::connect(repeatCheckBox, &QCheckBox::stateChanged, openDialog.get(), [&]() {
             // If the checkBox is now checked
@@ -642,17 +648,16 @@ void GoalsDashboard::editGoalsGoalSelected(QString areaName, QString goalName) {
         bool isNewGoal;
 
         // Check if the goal is a new goal or not and set the values
-        if (goalName == "Add new goal") {
+        if (goalId.isEmpty()) {
             newGoalName = newGoalNameEdit->text();
             isNewGoal = true;
         }
         else {
-            newGoalName = goalName;
             isNewGoal = false;
         }
 
         // Submit the goal
-        editGoalSubmit(areaName, newGoalName, QDate::currentDate(), endDateEdit->date(), editTarget->text(), isNewGoal, repeatCheckBox->isChecked(), repeatComboBox->currentText());
+        editGoalSubmit(areaName, goalId, newGoalName, QDate::currentDate(), endDateEdit->date(), editTarget->text(), isNewGoal, repeatCheckBox->isChecked(), repeatComboBox->currentText());
         openDialog->close();
     });
 
@@ -661,116 +666,49 @@ void GoalsDashboard::editGoalsGoalSelected(QString areaName, QString goalName) {
     openDialog->exec();
 }
 
-void GoalsDashboard::editGoalSubmit(QString areaName, QString goalName, QDate startDate, QDate endDate, QString target, bool isNewGoal, bool repeating, QString daysUntilRepeat) {
+void GoalsDashboard::editGoalSubmit(QString areaName, QString goalId, QString goalName, QDate startDate, QDate endDate, QString target, bool isNewGoal, bool repeating, QString daysUntilRepeat) {
     // Check if it is a new goal
     if (isNewGoal) {
-        // Create a new QJsonObject to populate
-        QJsonObject newGoal;
+        // Create a new goal to populate
+        Goal newGoal;
 
         // Add the name, current_value, end_date, start_date, and target value to the goal
-        newGoal["name"] = goalName;
-        newGoal["current_value"] = "0";
-        newGoal["end_date"] = endDate.toString();
-        newGoal["start_date"] = startDate.toString();
-        newGoal["target_value"] = target;
+        newGoal.name = goalName;
+        newGoal.setCurrentValue("0");
+        newGoal.endDate = endDate;
+        newGoal.startDate = startDate;
+        newGoal.setTargetValue(target);
 
         // Check if the goal is repeating
         if (repeating) {
             // set the end_date and add the days_until_repeat values
-            QString repeatDate = QDate::currentDate().addDays(daysUntilRepeat.toInt()).toString();
-            newGoal["end_date"] = repeatDate;
-            newGoal["days_until_repeat"] = daysUntilRepeat;
-        }
-
-        // Define the areaArray to add the goal to
-        QJsonArray areaArray = configJson[areaName].toArray();
-
-        // Iterate over the array
-        bool inserted = false;
-        QDate newGoalDate = QDate::fromString(endDate.toString(), "ddd MMM d yyyy");
-        for (int i = 0; i < areaArray.size(); ++i) {
-            QDate otherGoalDate = QDate::fromString(areaArray[i].toObject().value("end_date").toString(), "ddd MMM d yyyy");
-            // Check if the end_date for the new goal is before the end date of the checked goal
-            if (newGoalDate < otherGoalDate) {
-                // Put the goal in before the other goal
-                areaArray.insert(i, newGoal);
-                inserted = true;
-                break;
-            }
+            newGoal.endDate = QDate::currentDate().addDays(daysUntilRepeat.toInt());
+            newGoal.daysUntilRepeat = daysUntilRepeat.toInt();
         }
 
-        // If the goal was never inserted put the goal at the end of the array
-        if (!inserted) {
-            areaArray.append(newGoal);
-        }
-
-        // Make the array in the json data be the new areaArray
-        configJson[areaName] = areaArray;
+        // New goals go at the end of the area and the index puts them in order
+        goals.add(areaName, newGoal);
     }
-    else { // If the goal is not a new goal
-        // Go over each of the goals in the areaArray
-        QJsonArray goalsArray = configJson[areaName].toArray();
-        for (auto&& goal : goalsArray){
-            // Create a copy of the goal
-            QJsonObject goalObj = goal.toObject();
-            // If the goal is the desired goal (aka names match)
-            if (goalObj.value("name").toString() == goalName) {
-                // Set these values
-                goalObj["current_value"] = "0";
-                goalObj["end_date"] = endDate.toString();
-                goalObj["start_date"] = startDate.toString();
-                goalObj["target_value"] = target;
-
-                // Set the goal within the goalsArray to be the new goalObj
-                goal = goalObj;
-                break;
-            }
-        }
-
-        // BUBBLE SORT sorting goals by end_date
-        int n = goalsArray.size();
-        for (int i = 0; i < n -1; i++) {
-            for (int j = 0; j < n - i - 1; j++) {
-                QJsonObject obj1 = goalsArray[j].toObject();
-                QJsonObject obj2 = goalsArray[j + 1].toObject();
-                QDate date1 = QDate::fromString(obj1.value("end_date").toString(), "ddd MMM d yyyy");
-                QDate date2 = QDate::fromString(obj2.value("end_date").toString(), "ddd MMM d yyyy");
-                if (date1 > date2) {
-                    goalsArray[j] = obj2;
-                    goalsArray[j + 1] = obj1;
-                }
-            }
-        }
-
-        configJson[areaName] = goalsArray;
+    else { // If the goal is not a new goal, it starts over with the new target and dates
+        goals.setTargetValue(goalId, target);
+        goals.restart(goalId, startDate, endDate);
     }
 
-    // Rewrite the config.json file
-    rewriteJson();
+    // Write the area (config.json, or only this area's file)
+    storage.writeArea(areaName);
 
     // Previously I also would repopulate the areas, but because it is done whenever the file is changed
 }
 
-void GoalsDashboard::removeGoalSelected(QString areaName, QString goalName) {
-
-    // Make a copy of the areaArray (goalsArray)
-    QJsonArray goalsArray = configJson[areaName].toArray();
-
-    // Iterate over each of the goals in that array
-    for (int i = 0; i < goalsArray.size(); i++){
-        QJsonObject goalObj = goalsArray[i].toObject();
-
-        // If the goal is the goal we want to remove, remove it
-        if (goalObj.value("name").toString() == goalName) {
-            goalsArray.removeAt(i);
-            break;
-        }
+void GoalsDashboard::removeGoalSelected(QString goalId) {
+    // Remove the goal, the goals after it move up and the area keeps its order in the file
+    QString areaName = goals.areaOf(goalId);
+    if (!goals.remove(goalId)) {
+        return;
     }
-    // Replace the area Array in the configJson object with the copy
-    configJson[areaName] = goalsArray;
 
-    // Rewrite the config.json file
-    rewriteJson();
+    // Write the area (config.json, or only this area's file)
+    storage.writeArea(areaName);
 
     // Previously I also would repopulate the areas, but because it is done whenever the file is changed
 }
@@ -801,10 +739,8 @@ void GoalsDashboard::populateMenus() {
     }
 
     // Iterate over the categories
-    for (const QString& category : configJson.keys()) {
-        // Create a copy of the areaArray (currentCategoryArray)
-        QJsonArray currentCategoryArray = configJson.value(category).toArray();
-
+    ConfigSnapshotPtr snapshot = goals.snapshot();
+    for (const QString& category : snapshot->areaNames()) {
         // Create a submenu of the category
         QMenu *currentCategoryEditMenu = new QMenu(category);
         editGoalMenu->addMenu(currentCategoryEditMenu);
@@ -815,14 +751,11 @@ void GoalsDashboard::populateMenus() {
         removeGoalMenu->addMenu(currentCategoryRemoveMenu);
         currentCategoryRemoveMenu->setStyleSheet(styling);
 
-        // Iterate over the goals in the currentCategoryArray
-        for (const QJsonValue& currentValue : currentCategoryArray) {
-            // Create a copy of the goal
-            QJsonObject goalObj = currentValue.toObject();
-            QString goalName = goalObj.value("name").toString();
-            // Create Actions in each menu of that goalName
-            currentCategoryEditMenu->addAction(goalName);
-            currentCategoryRemoveMenu->addAction(goalName);
+        // Iterate over the goals in the category, soonest end date first
+        for (const Goal *goal : snapshot->ordered(category)) {
+            // Create Actions in each menu of that goal, they carry the goal's id so two goals with the same name are still different
+            currentCategoryEditMenu->addAction(goal->name)->setData(goal->id);
+            currentCategoryRemoveMenu->addAction(goal->name)->setData(goal->id);
         }
         // Add an action in ONLY the EDIT goal menu of Add new goal
         currentCategoryEditMenu->addAction("Add new goal");
@@ -834,21 +767,29 @@ void GoalsDashboard::populateMenus() {
  ********************************************************************************************************/
 
 
-void GoalsDashboard::fileChanged() {
-    // Get the new Json Data
-    try {
-        loadJson();
-    } catch (std::exception e) {
-        qCritical() << "error while loading goals file" << e.what();
-    } catch (...) {
-        qCritical() << "Unknown exception caught while loading goals config";
-    }
+void GoalsDashboard::fileChanged(const QString &area) {
+    // Get the new Json Data, the frames are updated once it's loaded
+    loadJson(area);
+}
 
-    // Repopulate the fullFrame->AreaFrames with the new information
-    fullFrame->repopulateAll();
-    qDebug() << "repopulating ebayFrame";
-    ebayFrame->repopulateGoals();
+void GoalsDashboard::splitConfig() {
+    storage.split([](const QString &error) {
+        if (!error.isEmpty()) {
+            QMessageBox::critical(nullptr, "Error", "Failed to split the config:\n" + error);
+            return;
+        }
+        QMessageBox::information(nullptr, "Info", "Every area now has its own file in config.d, config.json was kept as config.json.bak");
+    });
+}
 
+void GoalsDashboard::combineConfig() {
+    storage.combine([](const QString &error) {
+        if (!error.isEmpty()) {
+            QMessageBox::critical(nullptr, "Error", "Failed to combine the config:\n" + error);
+            return;
+        }
+        QMessageBox::information(nullptr, "Info", "The goals are back in config.json, config.d was kept as config.d.bak");
+    });
 }
 
 void GoalsDashboard::dailyTimerFinished(){
@@ -874,6 +815,19 @@ void GoalsDashboard::dailyTimerFinished(){
 
 
 void GoalsDashboard::jsonToCsv() {
+    // Reading history.json and writing the CSV both happen on the I/O thread, only the message box is shown here
+    io.run([]() {
+        return writeHistoryCsv();
+    }, this, [](const QString &error) {
+        if (!error.isEmpty()) {
+            QMessageBox::critical(nullptr, "Error", error);
+            return;
+        }
+        QMessageBox::information(nullptr, "Info", "CSV finished writing");
+    });
+}
+
+QString GoalsDashboard::writeHistoryCsv() {
     // Load JSON data
     QFile jsonFile("history.json");
     jsonFile.open(QFile::ReadOnly);
@@ -882,7 +836,7 @@ void GoalsDashboard::jsonToCsv() {
 
     // Prepare data for CSV
     QJsonObject jsonObject = doc.object();
-    QStringList categories = jsonObject.keys();
+    QStringList categories = ConfigSchema::areaNames(jsonObject);
     categories.removeOne("last_changed");
 
     // Prepare CSV data
@@ -914,28 +868,13 @@ void GoalsDashboard::jsonToCsv() {
         }
     }
 
-    // Get a filelock for the csv file
-    QLockFile lockFile("../history.csv.lock");
-    if (!lockFile.tryLock(1000)) {
-        QTimer::singleShot(10000, this, [=](){
-            jsonToCsv();
-        });
-        return;
-    }
-
-    // Write CSV data to file
-    QFile csvFile(csvFilePath);
-    if (csvFile.open(QIODevice::WriteOnly | QFile::Truncate)) {
-        csvFile.write(csvData.toUtf8());
-        csvFile.close();
-        lockFile.unlock();
-        QMessageBox::information(nullptr, "Info", "CSV finished writing");
-    } else {
-        QMessageBox::critical(nullptr, "Error", "Failed to open file for writing:\n" + csvFile.errorString());
+    // Write CSV data to file. It is made from history.json as a whole and replaced as a whole, so there is nothing to
+    // lock, whoever renames last wins and either way the file is complete
+    QSaveFile csvFile(csvFilePath);
+    if (!csvFile.open(QIODevice::WriteOnly) || csvFile.write(csvData.toUtf8()) < 0 || !csvFile.commit()) {
+        return "Failed to write " + csvFilePath + ":\n" + csvFile.errorString();
     }
-
-    // Unlock the filelock
-    lockFile.unlock();
+    return QString();
 }
 
 void GoalsDashboard::darkMode() {
@@ -23,6 +23,7 @@
 #include <QDateEdit>
 
 #include <QFile>
+#include <QSaveFile>
 #include <QLockFile>
 #include <QDir>
 #include <QFileSystemWatcher>
@@ -35,6 +36,7 @@
 #include <QAudio>
 #include <QRandomGenerator>
 #include <map>
+#include <functional>
 
 #pragma push_macro("slots")
 #undef slots
@@ -43,6 +45,11 @@
 
 #include "fullframe.h"
 #include "ebayframe.h"
+#include "retrypolicy.h"
+#include "configschema.h"
+#include "goalmodel.h"
+#include "configstorage.h"
+#include "ioqueue.h"
 
 class GoalsDashboard : public QMainWindow
 {
@@ -65,11 +72,15 @@ protected:
     void keyPressEvent(QKeyEvent *event) override;
 
 private:
-    QJsonObject configJson;
+    // Every goal, parsed once when config.json is loaded and turned back into JSON only when it is written
+    GoalModel goals;
+    // The thread every goal file is read and written on, declared before storage because storage queues onto it
+    IoQueue io;
+    // config.json or config.d/, reading, writing and watching them
+    ConfigStorage storage;
     FullFrame *fullFrame = nullptr;
     EbayFrame *ebayFrame = nullptr;
     QTimer *myDailyTimer;
-    QFileSystemWatcher watcher;
     QList<int> m_keySequence;
     QList<int> desiredSequence = {Qt::Key_Up, Qt::Key_Up, Qt::Key_Down, Qt::Key_Down, Qt::Key_Left, Qt::Key_Right, Qt::Key_Left, Qt::Key_Right, Qt::Key_B, Qt::Key_A};
     QFile sourceFile;
@@ -90,26 +101,35 @@ private:
  */
     void checkSequence();
 
-    void rewriteJson();
-
     void makeBackup();
 
     void updateHistory();
 
+    // Adds today's values to history.json, runs on the I/O thread
+    static IoQueue::WriteResult appendHistory(ConfigSnapshotPtr snapshot);
+
     void updateRepeating();
 
-    void loadJson();
+    // Reads everything again, or only area's file if it is given. loaded is called once it's done, whether it worked or not
+    void loadJson(const QString &area = QString(), std::function<void()> loaded = nullptr);
+
+    // Puts what was read into the goals and updates the menus and frames if anything changed
+    void applyJson(QJsonObject jsonObj);
+
+    // Makes ../history.csv from history.json, runs on the I/O thread. Gives back the error if there was one
+    static QString writeHistoryCsv();
 
     // THIS IS ALSO AN EASTER EGG
     void invertAll();
 
     void startDailyTimer();
 
-    void editGoalsGoalSelected(QString areaName, QString goalName);
+    // goalId is empty for "Add new goal"
+    void editGoalsGoalSelected(QString areaName, QString goalId);
 
-    void editGoalSubmit(QString areaName, QString goalName, QDate startDate, QDate endDate, QString target, bool isNewGoal, bool repeating, QString daysUntilRepeat);
+    void editGoalSubmit(QString areaName, QString goalId, QString goalName, QDate startDate, QDate endDate, QString target, bool isNewGoal, bool repeating, QString daysUntilRepeat);
 
-    void removeGoalSelected(QString areaName, QString goalName);
+    void removeGoalSelected(QString goalId);
 
     void populateMenus();
 
@@ -117,7 +137,11 @@ private:
 
 private slots:
 
-    void fileChanged();
+    void fileChanged(const QString &area);
+
+    void splitConfig();
+
+    void combineConfig();
 
     void dailyTimerFinished();
 
@@ -0,0 +1,35 @@
+#include "ioqueue.h"
+
+IoQueue::IoQueue(QObject *parent)
+    : QObject{parent}
+{
+    worker = new QObject;
+    worker->moveToThread(&thread);
+    QObject::connect(&thread, &QThread::finished, worker, &QObject::deleteLater);
+
+    thread.setObjectName("file I/O");
+    thread.start();
+}
+
+IoQueue::~IoQueue() {
+    // The quit is queued behind everything else, so the jobs still waiting get run before the thread stops
+    post([this]() {
+        thread.quit();
+    });
+    thread.wait();
+}
+
+void IoQueue::run(std::function<void()> job) {
+    post(std::move(job));
+}
+
+void IoQueue::post(std::function<void()> job) {
+    QMetaObject::invokeMethod(worker, [job = std::move(job)]() {
+        try {
+            job();
+        } catch (std::exception &e) {
+            // One job going wrong shouldn't take the thread (and every job after it) down
+            qCritical() << "file I/O job failed:" << e.what();
+        }
+    }, Qt::QueuedConnection);
+}
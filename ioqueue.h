@@ -0,0 +1,72 @@
+#ifndef IOQUEUE_H
+#define IOQUEUE_H
+
+#include <QObject>
+#include <QThread>
+#include <QPointer>
+#include <QString>
+#include <QDebug>
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+/*
+ * The thread the goal files are read and written on (config.json/config.d, the backups, history.json and history.csv,
+ * ebay.sales.json), so the window never waits on a disk or a lock file.
+ *
+ * Jobs run one at a time in the order they were queued. That way a read queued after a write sees what was written and
+ * two writes of the same file land in the order they were made, without any locking between the jobs themselves.
+ *
+ * A job only gets copies or immutable snapshots (ConfigSnapshotPtr) to work from, never the GoalModel or a widget. What
+ * it returns is handed to done back on the GUI thread, which is where the model is changed and any error dialog is
+ * shown. If context was deleted in the meantime done isn't called.
+ *
+ * Whatever is still queued when the queue is destroyed is run first, so nothing that was saved gets lost on exit.
+ */
+class IoQueue : public QObject
+{
+    Q_OBJECT
+public:
+    // What a job that writes a file under its lock gives back
+    struct WriteResult
+    {
+        // False if the lock was busy, the caller retries
+        bool locked = true;
+        QString error;
+    };
+
+    explicit IoQueue(QObject *parent = nullptr);
+
+    ~IoQueue();
+
+    // Runs job on the I/O thread and done(result) on this one
+    template <typename Job, typename Done>
+    void run(Job job, QObject *context, Done done) {
+        using Result = std::invoke_result_t<Job>;
+
+        QPointer<QObject> receiver(context);
+        post([this, job = std::move(job), receiver, done = std::move(done)]() mutable {
+            Result result = job();
+            // Queued on the queue itself (it lives on the GUI thread and outlives the I/O thread), context is only looked
+            // at once it's back on the GUI thread
+            QMetaObject::invokeMethod(this, [receiver, done = std::move(done), result = std::move(result)]() mutable {
+                if (receiver) {
+                    done(std::move(result));
+                }
+            }, Qt::QueuedConnection);
+        });
+    }
+
+    // Runs job on the I/O thread, nothing comes back
+    void run(std::function<void()> job);
+
+private:
+    QThread thread;
+    // Lives on thread, every job is a queued call on it
+    QObject *worker;
+
+    void post(std::function<void()> job);
+};
+
+#endif // IOQUEUE_H
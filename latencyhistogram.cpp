@@ -0,0 +1,100 @@
+#include "latencyhistogram.h"
+
+#include <QtAlgorithms>
+
+#include <cmath>
+
+void LatencyHistogram::record(qint64 micros) {
+    if (micros < 0) {
+        micros = 0;
+    }
+
+    counts[indexFor(micros)]++;
+    if (total == 0 || micros < min) {
+        min = micros;
+    }
+    if (micros > max) {
+        max = micros;
+    }
+    total++;
+    sum += micros;
+}
+
+qint64 LatencyHistogram::count() const {
+    return total;
+}
+
+qint64 LatencyHistogram::minMicros() const {
+    return min;
+}
+
+qint64 LatencyHistogram::maxMicros() const {
+    return max;
+}
+
+double LatencyHistogram::meanMicros() const {
+    return total == 0 ? 0 : double(sum) / total;
+}
+
+qint64 LatencyHistogram::percentile(double p) const {
+    if (total == 0) {
+        return 0;
+    }
+
+    // Walk the buckets until p percent of the values are behind us
+    qint64 target = qMax<qint64>(1, qint64(std::ceil(p / 100.0 * total)));
+    qint64 seen = 0;
+    for (int i = 0; i < bucketCount; i++) {
+        seen += counts[i];
+        if (seen >= target) {
+            // The top of the bucket, but never more than the largest value actually seen
+            return qMin(highestValueIn(i), max);
+        }
+    }
+    return max;
+}
+
+QString LatencyHistogram::summary() const {
+    if (total == 0) {
+        return "no calls yet";
+    }
+
+    return QString::number(total) + " calls, p50 " + formatMicros(percentile(50))
+           + ", p95 " + formatMicros(percentile(95))
+           + ", p99 " + formatMicros(percentile(99))
+           + ", max " + formatMicros(max);
+}
+
+QString LatencyHistogram::formatMicros(qint64 micros) {
+    if (micros < 1000) {
+        return QString::number(micros) + " us";
+    }
+    if (micros < 1000 * 1000) {
+        return QString::number(micros / 1000.0, 'f', micros < 10 * 1000 ? 1 : 0) + " ms";
+    }
+    return QString::number(micros / 1000000.0, 'f', 2) + " s";
+}
+
+int LatencyHistogram::indexFor(qint64 micros) {
+    if (micros < 2 * subBuckets) {
+        return int(micros);
+    }
+
+    // Position of the highest set bit, then keep the 5 bits below and including it
+    int exponent = 63 - qCountLeadingZeroBits(quint64(micros));
+    if (exponent > maxExponent) {
+        return bucketCount - 1;
+    }
+    int shift = exponent - 4;
+    return shift * subBuckets + int(micros >> shift);
+}
+
+qint64 LatencyHistogram::highestValueIn(int index) {
+    if (index < 2 * subBuckets) {
+        return index;
+    }
+
+    int shift = index / subBuckets - 1;
+    qint64 subBucket = index % subBuckets + subBuckets;
+    return ((subBucket + 1) << shift) - 1;
+}
@@ -0,0 +1,52 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QString>
+#include <QtGlobal>
+
+#include <array>
+
+/*
+ * HDR style latency histogram. Values (in microseconds) go into log-linear buckets: every power of two is split into 16
+ * equal buckets, so any value is kept to within about 6% no matter if it is 200us or 20s, and the whole thing is a fixed
+ * array of counters (recording is just an increment, nothing is ever allocated).
+ */
+class LatencyHistogram
+{
+public:
+    void record(qint64 micros);
+
+    qint64 count() const;
+
+    qint64 minMicros() const;
+
+    qint64 maxMicros() const;
+
+    double meanMicros() const;
+
+    // The value p percent of the recorded values are at or below (p from 0 to 100)
+    qint64 percentile(double p) const;
+
+    // One line like "12 calls, p50 310 ms, p95 820 ms, p99 1.2 s, max 1.4 s"
+    QString summary() const;
+
+    static QString formatMicros(qint64 micros);
+
+private:
+    // Values below 32us get a bucket each, after that 16 buckets per power of two up to 2^40us (about 12 days)
+    static const int subBuckets = 16;
+    static const int maxExponent = 40;
+    static const int bucketCount = (maxExponent - 2) * subBuckets;
+
+    std::array<qint64, bucketCount> counts{};
+    qint64 total = 0;
+    qint64 sum = 0;
+    qint64 min = 0;
+    qint64 max = 0;
+
+    static int indexFor(qint64 micros);
+
+    static qint64 highestValueIn(int index);
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -6,6 +6,7 @@ from selenium import webdriver
 from selenium.common.exceptions import NoSuchWindowException
 from urllib.parse import unquote
 import json
+import os
 import webbrowser
 import asyncio
 import aiohttp
@@ -48,14 +49,26 @@ class MyDashboard:
 	
 
 	def load_configuration(self):
-		with FileLock(CONFIG_LOCATION + ".lock"):
-			with open(CONFIG_LOCATION, 'r') as file:
-				self.config = json.load(file)
+		# No lock, the file is only ever replaced whole (here and by the dashboard) so it is always complete
+		with open(CONFIG_LOCATION, 'r') as file:
+			self.config = json.load(file)
 
 	def save_configuration(self):
+		# The file is read again under the lock and only the refresh token is changed in it, the dashboard writes new
+		# access tokens into it while this is open. The rename means readers never see half a file
 		with FileLock(CONFIG_LOCATION + ".lock"):
-			with open(CONFIG_LOCATION, 'w') as config_file:
-				json.dump(self.config, config_file, indent=4)
+			with open(CONFIG_LOCATION, 'r') as file:
+				config = json.load(file)
+			for key in ('refresh_token', 'refresh_token_expires_at'):
+				config['eBay'][key] = self.config['eBay'][key]
+			self.config = config
+
+			temporary = CONFIG_LOCATION + ".tmp"
+			with open(temporary, 'w') as config_file:
+				json.dump(config, config_file, indent=4)
+				config_file.flush()
+				os.fsync(config_file.fileno())
+			os.replace(temporary, CONFIG_LOCATION)
 	
 
 	async def make_call(self, request_type: str, url: str, headers: dict, data: str = None, auth: tuple = None):
@@ -0,0 +1,145 @@
+#include "retrypolicy.h"
+
+RetryPolicy &RetryPolicy::shared() {
+    static RetryPolicy policy;
+    return policy;
+}
+
+int RetryPolicy::scheduleRetry(const QString &key, QObject *context, std::function<void()> retry, int minDelayMs) {
+    int delay;
+    {
+        QMutexLocker locker(&mutex);
+        State &state = states[key];
+
+        delay = qMax(backoffMs(state.attempt), minDelayMs);
+        state.attempt++;
+        state.counters.retries++;
+        retriesIssued++;
+
+        // No point trying before the breaker lets anything through again
+        if (state.counters.circuitOpen) {
+            qint64 untilHalfOpen = QDateTime::currentDateTime().msecsTo(state.openUntil);
+            if (untilHalfOpen > delay) {
+                delay = int(untilHalfOpen);
+            }
+        }
+
+        pending.insert(key);
+    }
+
+    qDebug() << "retrying" << key << "in" << delay << "ms";
+
+    // If context goes away during the backoff the timer never fires, so the key is cleared when it is destroyed instead.
+    // Otherwise it would stay pending for good and every later "retry pending" check would skip that key
+    auto destroyedConnection = std::make_shared<QMetaObject::Connection>();
+    *destroyedConnection = QObject::connect(context, &QObject::destroyed, [this, key]() {
+        QMutexLocker locker(&mutex);
+        pending.remove(key);
+    });
+
+    QTimer::singleShot(delay, context, [this, key, retry, destroyedConnection]() {
+        QObject::disconnect(*destroyedConnection);
+        {
+            QMutexLocker locker(&mutex);
+            pending.remove(key);
+        }
+        retry();
+    });
+    return delay;
+}
+
+bool RetryPolicy::isRetryPending(const QString &key) const {
+    QMutexLocker locker(&mutex);
+    return pending.contains(key);
+}
+
+void RetryPolicy::succeeded(const QString &key) {
+    QMutexLocker locker(&mutex);
+    auto it = states.find(key);
+    if (it == states.end()) {
+        return;
+    }
+
+    if (it->counters.circuitOpen) {
+        qDebug() << "circuit closed for" << key;
+    }
+    it->attempt = 0;
+    it->probing = false;
+    it->counters.consecutiveFailures = 0;
+    it->counters.circuitOpen = false;
+}
+
+void RetryPolicy::failed(const QString &key) {
+    QMutexLocker locker(&mutex);
+    State &state = states[key];
+    state.counters.failures++;
+    state.counters.consecutiveFailures++;
+
+    // A failed probe opens the circuit again straight away, otherwise it opens once enough failures pile up
+    if (state.probing || (!state.counters.circuitOpen && state.counters.consecutiveFailures >= failureThreshold)) {
+        state.counters.circuitOpen = true;
+        state.counters.circuitOpens++;
+        state.openUntil = QDateTime::currentDateTime().addMSecs(openMs);
+        qDebug() << "circuit open for" << key << "after" << state.counters.consecutiveFailures << "failures";
+    }
+    state.probing = false;
+}
+
+bool RetryPolicy::tryLock(QLockFile &lockFile, const QString &key, int timeoutMs) {
+    // Timed outside the mutex, the wait itself can take up to timeoutMs
+    QElapsedTimer timer;
+    timer.start();
+    bool locked = lockFile.tryLock(timeoutMs);
+    qint64 waitedMs = timer.elapsed();
+
+    QMutexLocker locker(&mutex);
+    Counters &counters = states[key].counters;
+    counters.lockWaits++;
+    counters.lockWaitMsTotal += waitedMs;
+    counters.lockWaitMsMax = qMax(counters.lockWaitMsMax, waitedMs);
+    if (!locked) {
+        counters.lockTimeouts++;
+    }
+    return locked;
+}
+
+bool RetryPolicy::allowRequest(const QString &key) {
+    QMutexLocker locker(&mutex);
+    auto it = states.find(key);
+    if (it == states.end() || !it->counters.circuitOpen) {
+        return true;
+    }
+
+    // Half open: once the wait is over let exactly one request through to test the endpoint
+    if (!it->probing && QDateTime::currentDateTime() >= it->openUntil) {
+        it->probing = true;
+        return true;
+    }
+    return false;
+}
+
+QMap<QString, RetryPolicy::Counters> RetryPolicy::counters() const {
+    QMutexLocker locker(&mutex);
+    QMap<QString, Counters> result;
+    for (auto it = states.constBegin(); it != states.constEnd(); it++) {
+        result.insert(it.key(), it->counters);
+    }
+    return result;
+}
+
+qint64 RetryPolicy::totalRetries() const {
+    QMutexLocker locker(&mutex);
+    return retriesIssued;
+}
+
+int RetryPolicy::backoffMs(int attempt) const {
+    // base * 2^attempt, capped (the shift is capped too so it can't overflow)
+    qint64 delay = qint64(baseDelayMs) << qMin(attempt, 20);
+    if (delay > maxDelayMs) {
+        delay = maxDelayMs;
+    }
+
+    // Half of it fixed and half random, so retries that started together spread out
+    qint64 half = delay / 2;
+    return int(half + QRandomGenerator::global()->bounded(half + 1));
+}
@@ -0,0 +1,106 @@
+#ifndef RETRYPOLICY_H
+#define RETRYPOLICY_H
+
+#include <QObject>
+#include <QString>
+#include <QMap>
+#include <QSet>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTimer>
+#include <QLockFile>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QDebug>
+
+#include <functional>
+#include <memory>
+
+/*
+ * Every "try again later" in the dashboard goes through here instead of a fixed QTimer::singleShot(5000, ...).
+ *
+ * Retries are tracked per key (a lock file like "lock:config.json" or an endpoint like "ebay:orders"). Each failed attempt
+ * doubles the wait up to a cap, and the wait is randomized (half fixed, half random) so several windows or instances that
+ * failed at the same time don't all come back at the same moment and collide again.
+ *
+ * Network endpoints also get a circuit breaker: after enough failures in a row the endpoint is left alone for a while,
+ * then a single request is let through to see if it works again before everything else is.
+ *
+ * Lock files are taken through tryLock() here as well, which records how long every lock (same "lock:<file>" keys) had
+ * to be waited for and how often it couldn't be had at all.
+ *
+ * Shared by the GUI thread and the eBay network thread, so everything is behind a mutex.
+ */
+class RetryPolicy
+{
+public:
+    struct Counters
+    {
+        // Retries scheduled over the whole run
+        qint64 retries = 0;
+        qint64 failures = 0;
+        // How many times the circuit breaker opened
+        qint64 circuitOpens = 0;
+        int consecutiveFailures = 0;
+        bool circuitOpen = false;
+        // Lock files: how often one was taken, how often it timed out, and the time spent waiting for it
+        qint64 lockWaits = 0;
+        qint64 lockTimeouts = 0;
+        qint64 lockWaitMsTotal = 0;
+        qint64 lockWaitMsMax = 0;
+    };
+
+    static const int baseDelayMs = 1000;
+    static const int maxDelayMs = 5 * 60 * 1000;
+    // Failures in a row before an endpoint's circuit opens, and how long it stays open
+    static const int failureThreshold = 5;
+    static const int openMs = 2 * 60 * 1000;
+
+    // The one instance everything shares, so the counters cover the whole process
+    static RetryPolicy &shared();
+
+    // Run retry on context's thread after the backoff for key (but not before minDelayMs). If key's circuit is open this
+    // waits until it half opens. Returns the delay that was used.
+    // key stays pending (isRetryPending()) until the retry runs or context is destroyed
+    int scheduleRetry(const QString &key, QObject *context, std::function<void()> retry, int minDelayMs = 0);
+
+    // True while a retry for key is scheduled (so a regular poll can leave it to the retry)
+    bool isRetryPending(const QString &key) const;
+
+    // Record the outcome of an attempt. Success resets the backoff and closes the circuit
+    void succeeded(const QString &key);
+
+    void failed(const QString &key);
+
+    // QLockFile::tryLock(timeoutMs), with the time it took recorded under key
+    bool tryLock(QLockFile &lockFile, const QString &key, int timeoutMs = 1000);
+
+    // The circuit breaker check, false means don't send anything for key right now
+    bool allowRequest(const QString &key);
+
+    QMap<QString, Counters> counters() const;
+
+    qint64 totalRetries() const;
+
+private:
+    struct State
+    {
+        Counters counters;
+        // Drives the backoff, goes up with every scheduled retry and back to 0 on success
+        int attempt = 0;
+        QDateTime openUntil;
+        bool probing = false;
+    };
+
+    mutable QMutex mutex;
+    QMap<QString, State> states;
+    QSet<QString> pending;
+    qint64 retriesIssued = 0;
+
+    RetryPolicy() = default;
+
+    int backoffMs(int attempt) const;
+};
+
+#endif // RETRYPOLICY_H
@@ -0,0 +1,14 @@
+#include "stalebanner.h"
+
+QString StaleBanner::css() {
+    return ".stale { font-size: 0.6em; font-style: italic; opacity: 0.7; margin: 0; }";
+}
+
+QString StaleBanner::html(qint64 staleSinceMs) {
+    if (staleSinceMs == 0) {
+        return QString();
+    }
+
+    qint64 minutes = (QDateTime::currentMSecsSinceEpoch() - staleSinceMs) / 60000;
+    return "<p class='stale'>Updated " + (minutes < 1 ? QString("less than a minute") : QString::number(minutes) + " min") + " ago, refreshing...</p>";
+}
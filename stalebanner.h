@@ -0,0 +1,21 @@
+#ifndef STALEBANNER_H
+#define STALEBANNER_H
+
+#include <QString>
+#include <QDateTime>
+
+/*
+ * The "Updated N min ago, refreshing..." line the eBay panels show above stale data from the cache while the new copy
+ * is on its way. Every panel renders it the same, so its markup and its CSS rule live here.
+ */
+class StaleBanner
+{
+public:
+    // The CSS rule for the banner, goes inside the page's <style>
+    static QString css();
+
+    // The banner for data fetched at staleSinceMs, empty if staleSinceMs is 0 (the data is fresh)
+    static QString html(qint64 staleSinceMs);
+};
+
+#endif // STALEBANNER_H